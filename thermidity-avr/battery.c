@@ -0,0 +1,167 @@
+/*
+ * File:   battery.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:10
+ */
+
+#include <math.h>
+#include "battery.h"
+#include "meter.h"
+#include "config.h"
+#include "utils.h"
+
+/* Points of a discharge curve, 100% to 0% in steps of 10% */
+#define CURVE_POINTS    11
+
+/* Charge in µAs consumed in each state */
+static const __flash uint16_t charges[] = {
+    // CHARGE_MEASURE
+    (CUR_SETTLE * (uint32_t)DUR_SETTLE + CUR_ADC * (uint32_t)DUR_ADC) / 1000,
+    // CHARGE_RENDER
+    CUR_RENDER * (uint32_t)DUR_RENDER / 1000,
+    // CHARGE_FULL
+    CUR_REFRESH * (uint32_t)DUR_FULL / 1000,
+    // CHARGE_FAST
+    CUR_REFRESH * (uint32_t)DUR_FAST / 1000,
+    // CHARGE_SD
+    CUR_SD * (uint32_t)DUR_SD / 1000
+};
+
+/*
+ * Cell voltage in mV at light load by state of charge of each chemistry.
+ * Alkaline cells discharge along a slope, NiMH and Li-FeS2 cells stay on
+ * a plateau for most of their capacity before dropping at the knee.
+ */
+static const __flash uint16_t curves[CHEMS][CURVE_POINTS] = {
+    // CHEM_ALKALINE
+    {1590, 1440, 1390, 1350, 1310, 1270, 1230, 1190, 1150, 1100, 1000},
+    // CHEM_NIMH
+    {1400, 1300, 1270, 1250, 1240, 1230, 1220, 1200, 1180, 1130, 1000},
+    // CHEM_LITHIUM
+    {1800, 1520, 1500, 1480, 1460, 1450, 1430, 1400, 1350, 1250, 1000}
+};
+
+static BatteryState battery;
+
+/* If the state was restored and the batteries may have been replaced */
+static bool verify = false;
+
+/* Battery voltage in mV divided by 5 when the state was saved */
+static int16_t restoredMV5;
+
+/**
+ * Returns the state of charge in % of a cell of the configured chemistry
+ * with the given voltage in mV, interpolated linearly between the points
+ * of its discharge curve.
+ * @param mv
+ * @return state of charge
+ */
+static uint8_t calcVoltageSoc(int16_t mv) {
+    const __flash uint16_t *curve = curves[config.batChem];
+    if (mv >= (int16_t)curve[0]) {
+        return 100;
+    }
+
+    for (uint8_t i = 1; i < CURVE_POINTS; i++) {
+        int16_t upper = curve[i - 1];
+        int16_t lower = curve[i];
+        if (mv > lower) {
+            return 100 - 10 * i +
+                    divRoundNearest((mv - lower) * 10L, upper - lower);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Returns the state of charge in % according to the consumed charge and
+ * the configured capacity.
+ * @return state of charge
+ */
+static uint8_t calcChargeSoc(void) {
+    // µAh per % of capacity
+    uint32_t pct = config.batMAh * 10UL;
+    uint32_t used = battery.uah / pct;
+
+    return used < 100 ? 100 - used : 0;
+}
+
+void accountSleep(uint16_t secs) {
+    battery.secs += secs;
+    uint32_t uas = battery.uas + (uint32_t)CUR_SLEEP * secs;
+    battery.uah += uas / 3600;
+    battery.uas = uas % 3600;
+}
+
+void accountCharge(uint8_t state) {
+    // charges above 2^16 - 3600 µAs would overflow
+    uint16_t uas = battery.uas + charges[state];
+    battery.uah += uas / 3600;
+    battery.uas = uas % 3600;
+}
+
+void resetBattery(void) {
+    battery = (BatteryState) {0};
+    verify = false;
+}
+
+void checkBattery(void) {
+    if (verify) {
+        verify = false;
+        if (getMVBat() > restoredMV5 + BAT_SWAP) {
+            resetBattery();
+        }
+    }
+}
+
+void getBatteryState(BatteryState *state) {
+    *state = battery;
+}
+
+void setBatteryState(const BatteryState *state, int16_t mv5) {
+    battery = *state;
+    restoredMV5 = mv5;
+    verify = true;
+}
+
+uint8_t calcSoc(void) {
+    // measured battery voltage is /5 by voltage divider, weak cells 
+    // show under load
+    int16_t cellMV = getMVBatLoad() * 5L / config.batCells;
+    uint8_t voltageSoc = calcVoltageSoc(cellMV);
+    uint8_t chargeSoc = calcChargeSoc();
+
+    return voltageSoc < chargeSoc ? voltageSoc : chargeSoc;
+}
+
+int16_t estimateDays(void) {
+    if (battery.secs < DAYS_MIN_SECS || battery.uah == 0) {
+        return -1;
+    }
+
+    // average current in µA since the batteries were replaced
+    float hours = battery.secs / 3600.0;
+    float ua = battery.uah / hours;
+    // remaining charge in µAh
+    float uah = config.batMAh * 10.0 * calcSoc();
+
+    return fmin(uah / ua / 24, INT16_MAX);
+}
+
+uint16_t estimateResistance(void) {
+    int16_t drop = getMVBat() - getMVBatLoad();
+    if (drop <= 0) {
+        return 0;
+    }
+    
+    // mV / µA = kΩ, drop is /5 by voltage divider
+    uint32_t mohm = drop * 5000000UL / CUR_REFRESH;
+    
+    return mohm < UINT16_MAX ? mohm : UINT16_MAX;
+}
+
+uint16_t getConsumedMAh(void) {
+    return battery.uah / 1000;
+}
@@ -0,0 +1,143 @@
+/*
+ * File:   battery.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:10
+ */
+
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Battery chemistries with a discharge curve */
+#define CHEM_ALKALINE   0
+#define CHEM_NIMH       1
+#define CHEM_LITHIUM    2 // Li-FeS2 primary cells
+#define CHEMS           3
+
+/** Default chemistry, number of cells and capacity, 3 AAA batteries */
+#define BAT_CHEM        CHEM_ALKALINE
+#define BAT_CELLS       3
+#define BAT_MAH         1100
+
+/**
+ * Current in µA and duration in ms of each state the charge is accounted
+ * for, as measured at 3.8V, see README. The time asleep is counted with
+ * the watchdog, the durations of the other states are nominal and can be
+ * checked with a build with TIMING.
+ */
+#define CUR_SLEEP       19    // MCU in power-down, display in deep sleep
+#define CUR_SETTLE      240   // sensors powered on and settling
+#define DUR_SETTLE      100
+#define CUR_ADC         2000  // ADC noise reduction mode
+#define DUR_ADC         6
+#define CUR_RENDER      3000  // MCU drawing the frame to the SRAM
+#define DUR_RENDER      200
+#define CUR_REFRESH     6000  // display updating
+#define DUR_FULL        3000
+#define DUR_FAST        1500
+#define CUR_SD          30000 // SD card powered on and writing
+#define DUR_SD          500
+
+/** States the charge is accounted for */
+#define CHARGE_MEASURE  0
+#define CHARGE_RENDER   1
+#define CHARGE_FULL     2
+#define CHARGE_FAST     3
+#define CHARGE_SD       4
+
+/**
+ * Minimum rise of the battery voltage in millivolts divided by 5 after a
+ * reset to assume the batteries were replaced
+ */
+#define BAT_SWAP        64
+
+/** Minimum number of seconds elapsed to estimate the days remaining */
+#define DAYS_MIN_SECS   3600
+
+/**
+ * Charge consumed from the batteries and time elapsed since they were
+ * replaced, to be restored after a reset.
+ */
+typedef struct {
+    /** Consumed charge in µAh. */
+    uint32_t uah;
+    /** Consumed charge in µAs not yet added to uah. */
+    uint16_t uas;
+    /** Elapsed time in seconds. */
+    uint32_t secs;
+} BatteryState;
+
+/**
+ * Accounts for the charge consumed while asleep for the given number of
+ * seconds and counts the time elapsed.
+ * @param secs
+ */
+void accountSleep(uint16_t secs);
+
+/**
+ * Accounts for the charge consumed in the given state.
+ * @param state one of CHARGE_*
+ */
+void accountCharge(uint8_t state);
+
+/**
+ * Starts accounting from zero, i.e. after the batteries were replaced.
+ */
+void resetBattery(void);
+
+/**
+ * Starts accounting from zero if the battery voltage rose significantly
+ * since the state was restored, assuming the batteries were replaced.
+ * To be called after measuring.
+ */
+void checkBattery(void);
+
+/**
+ * Copies the consumed charge and elapsed time to the given state.
+ * @param state
+ */
+void getBatteryState(BatteryState *state);
+
+/**
+ * Restores the consumed charge and elapsed time from the given state, 
+ * saved at the given battery voltage in mV divided by 5.
+ * @param state
+ * @param mv5
+ */
+void setBatteryState(const BatteryState *state, int16_t mv5);
+
+/**
+ * Returns the estimated state of charge in %, the lower of the state of
+ * charge according to the discharge curve of the configured chemistry
+ * at the voltage under load and the one according to the consumed charge.
+ * @return state of charge
+ */
+uint8_t calcSoc(void);
+
+/**
+ * Returns the estimated number of days until the batteries are empty
+ * at the average consumption so far, or -1 if not yet known.
+ * @return days remaining
+ */
+int16_t estimateDays(void);
+
+/**
+ * Returns the internal resistance of the batteries in mΩ estimated from 
+ * the voltage drop under the load of a display update, at most UINT16_MAX,
+ * or 0 if it was not measured under load yet. For information only, the 
+ * cutoff and the state of charge use the voltage under that load, which
+ * already includes the drop.
+ * @return internal resistance
+ */
+uint16_t estimateResistance(void);
+
+/**
+ * Returns the consumed charge in mAh.
+ * @return consumed charge
+ */
+uint16_t getConsumedMAh(void);
+
+#endif /* BATTERY_H */
@@ -0,0 +1,190 @@
+/* 
+ * File:   cmd.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:02
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmd.h"
+#include "config.h"
+#include "meter.h"
+#include "history.h"
+#include "battery.h"
+#include "usart.h"
+#include "timing.h"
+
+/**
+ * Prints the given parameter name and value.
+ * @param name
+ * @param value
+ */
+static void printParam(const char *name, uint16_t value) {
+    char buf[16];
+    snprintf(buf, sizeof (buf), "%s=%u\r\n", name, value);
+    printString(buf);
+}
+
+/**
+ * Prints the given parameter or all parameters if name is NULL.
+ * @param name
+ */
+static void get(const char *name) {
+    if (name == NULL) {
+        forEachParam(printParam);
+        return;
+    }
+    
+    uint16_t value;
+    if (getParam(name, &value)) {
+        printParam(name, value);
+    } else {
+        printString("?\r\n");
+    }
+}
+
+/**
+ * Parses the given string as decimal number up to UINT16_MAX, without 
+ * sign, whitespace or anything else.
+ * @param string
+ * @param value
+ * @return true if the string is such a number, false otherwise
+ */
+static bool parseUint(const char *string, uint16_t *value) {
+    if (string == NULL || *string < '0' || *string > '9') {
+        return false;
+    }
+    
+    char *end;
+    unsigned long val = strtoul(string, &end, 10);
+    if (*end != '\0' || val > UINT16_MAX) {
+        return false;
+    }
+    *value = val;
+    
+    return true;
+}
+
+/**
+ * Sets the given parameter to the given value.
+ * @param name
+ * @param value
+ */
+static void set(const char *name, const char *value) {
+    uint16_t old;
+    uint16_t val;
+    if (name == NULL || !parseUint(value, &val) || !getParam(name, &old) || 
+            !setParam(name, val)) {
+        printString("?\r\n");
+        return;
+    }
+    
+    if (config.ewmaBs != old && strcmp(name, "ewma") == 0) {
+        // averages are scaled by the weight
+        resetAverages();
+    }
+    get(name);
+}
+
+/**
+ * Prints the current temperature, relative humidity and battery voltage.
+ */
+static void status(void) {
+    Sample values = calcValues();
+    div_t tmp = div(values.tmpx10, 10);
+    div_t bat = div(values.vBatx10, 10);
+    char buf[40];
+    snprintf(buf, sizeof (buf), "tmp=%s%d.%d rh=%d bat=%d.%d\r\n",
+            values.tmpx10 < 0 ? "-" : "", abs(tmp.quot), abs(tmp.rem), 
+            values.rh, bat.quot, bat.rem);
+    printString(buf);
+}
+
+/**
+ * Prints the estimated state of charge, days remaining, consumed charge
+ * and internal resistance of the batteries.
+ */
+static void battery(void) {
+    char buf[56];
+    snprintf(buf, sizeof (buf), "soc=%u days=%d used=%umAh ri=%umOhm\r\n",
+            calcSoc(), estimateDays(), getConsumedMAh(), 
+            estimateResistance());
+    printString(buf);
+}
+
+/**
+ * Prints counters of measurements, display updates and the history length.
+ */
+static void stats(void) {
+    const MeterStats *meter = getMeterStats();
+    char buf[72];
+    snprintf(buf, sizeof (buf), 
+            "measure=%lu full=%u fast=%u skipped=%u history=%u\r\n",
+            (unsigned long)meter->measurements, meter->fullUpdates, 
+            meter->fastUpdates, meter->skippedUpdates, historyLength());
+    printString(buf);
+}
+
+#if TIMING
+/**
+ * Prints the accumulated time and count of each phase and the time awake
+ * and asleep in milliseconds.
+ */
+static void timing(void) {
+    static const __flash char names[PHASES][9] = {
+        "settle", "adc", "render", "transfer", "busy"
+    };
+    const Timing *phases = getTiming();
+    char buf[40];
+    for (uint8_t i = 0; i < PHASES; i++) {
+        char name[sizeof (names[i])];
+        for (uint8_t c = 0; c < sizeof (name); c++) {
+            name[c] = names[i][c];
+        }
+        snprintf(buf, sizeof (buf), "%s=%lums/%u\r\n", name, 
+                (unsigned long)(phases->ticks[i] / TIMING_TICKS_MS), 
+                phases->counts[i]);
+        printString(buf);
+    }
+    uint32_t awake = phases->awake / TIMING_TICKS_MS;
+    uint32_t total = phases->seconds * 1000UL;
+    snprintf(buf, sizeof (buf), "awake=%lums sleep=%lums\r\n", 
+            (unsigned long)awake, (unsigned long)(total - awake));
+    printString(buf);
+}
+#endif
+
+void runCommand(char *line) {
+    char *cmd = strtok(line, " ");
+    if (cmd == NULL) {
+        return;
+    }
+    char *arg1 = strtok(NULL, " ");
+    char *arg2 = strtok(NULL, " ");
+    
+    if (strcmp(cmd, "get") == 0) {
+        get(arg1);
+    } else if (strcmp(cmd, "set") == 0) {
+        set(arg1, arg2);
+    } else if (strcmp(cmd, "save") == 0) {
+        saveConfig();
+        printString("saved\r\n");
+    } else if (strcmp(cmd, "status") == 0) {
+        status();
+    } else if (strcmp(cmd, "battery") == 0) {
+        battery();
+    } else if (strcmp(cmd, "newbat") == 0) {
+        resetBattery();
+        battery();
+    } else if (strcmp(cmd, "stats") == 0) {
+        stats();
+#if TIMING
+    } else if (strcmp(cmd, "timing") == 0) {
+        timing();
+#endif
+    } else {
+        printString("?\r\n");
+    }
+}
@@ -0,0 +1,24 @@
+/* 
+ * File:   cmd.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:02
+ */
+
+#ifndef CMD_H
+#define CMD_H
+
+/**
+ * Runs the command in the given line received via USART and prints the
+ * result. Commands are:
+ * get [name]: prints the value of the given or of all parameters
+ * set name value: sets the given parameter to the given value
+ * save: saves the parameters to the EEPROM
+ * status: prints the current values
+ * stats: prints counters of measurements and display updates
+ * timing: prints the time spent in each phase if built with TIMING
+ * @param line
+ */
+void runCommand(char *line);
+
+#endif /* CMD_H */
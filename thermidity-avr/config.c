@@ -0,0 +1,239 @@
+/* 
+ * File:   config.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:02
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "config.h"
+#include "meter.h"
+#include "battery.h"
+#include "display.h"
+#include "utils.h"
+
+/* Maximum length of a parameter name including the null terminator */
+#define PARAM_NAME  8
+
+/* Portrait orientation only if the panel is wide enough for the layout */
+#define ORIENT_MAX  (DISPLAY_HEIGHT >= PORTRAIT_MIN_WIDTH ? \
+                     ORIENT_PORTRAIT : ORIENT_LANDSCAPE)
+
+/**
+ * Name, offset and size in the configuration and limits of a parameter.
+ */
+typedef struct {
+    const char name[PARAM_NAME];
+    uint8_t offset;
+    uint8_t size;
+    uint16_t min;
+    uint16_t max;
+} Param;
+
+#define PARAM(name, field, min, max) \
+    {name, offsetof(Config, field), sizeof (((Config *)0)->field), min, max}
+
+static const __flash Param params[] = {
+    PARAM("measure", measureInts, 1, 60),
+    // keep the periods well within the range of the scheduler time
+    PARAM("update",  dispUpdInts, 1, 240),
+    PARAM("fast",    dispMaxFast, 0, 255),
+    PARAM("ewma",    ewmaBs,      0, 8),
+    PARAM("hysttmp", hystTmpx10,  1, 255),
+    PARAM("hystrh",  hystRh,      1, 255),
+    PARAM("aref",    arefMV,      1000, 1200),
+    PARAM("rh0",     rhADC0,      0, 4095),
+    PARAM("rh100",   rhADC100,    0, 4095),
+    PARAM("batlow",  batLowMV,    2000, 5000),
+    PARAM("chem",    batChem,     0, CHEMS - 1),
+    PARAM("cells",   batCells,    1, 4),
+    PARAM("mah",     batMAh,      100, 20000),
+    PARAM("dark",    darkMode,    0, 1),
+    PARAM("orient",  orient,      0, ORIENT_MAX)
+};
+
+Config config = {
+    .measureInts = MEASURE_INTS,
+    .dispUpdInts = DISP_UPD_INTS,
+    .dispMaxFast = DISP_MAX_FAST,
+    .ewmaBs = EWMA_BS,
+    .hystTmpx10 = DISP_HYST_TMP,
+    .hystRh = DISP_HYST_RH,
+    .batChem = BAT_CHEM,
+    .batCells = BAT_CELLS,
+    .darkMode = 0,
+    .orient = ORIENT_LANDSCAPE,
+    .arefMV = AREF_MV,
+    .rhADC0 = RH_ADC_0,
+    .rhADC100 = RH_ADC_100,
+    .batLowMV = BAT_LOW,
+    .batMAh = BAT_MAH
+};
+
+Derived derived;
+
+static ConfigBlock EEMEM eeConfig;
+
+/**
+ * Calculates the CRC of the given configuration block without its CRC.
+ * @param block
+ * @return CRC
+ */
+static uint16_t calcCRC(const ConfigBlock *block) {
+    const uint8_t *data = (const uint8_t *)block;
+    uint16_t crc = 0xffff;
+    for (uint8_t i = 0; i < offsetof(ConfigBlock, crc); i++) {
+        crc = _crc16_update(crc, data[i]);
+    }
+    
+    return crc;
+}
+
+/**
+ * Returns true if the humidity sensor calibration is usable, i.e. the ADC
+ * value at 100%RH is sufficiently above the one at 0%RH.
+ * @return true if valid
+ */
+static bool isValid(void) {
+    return config.rhADC100 >= config.rhADC0 + RH_ADC_SPAN;
+}
+
+/**
+ * Derives the values used in the hot paths from the configuration.
+ */
+static void derive(void) {
+    uint16_t span = config.rhADC100 - config.rhADC0;
+    derived.rhPerADC = ((100UL << 20) + span / 2) / span;
+    derived.batLow5 = config.batLowMV / 5;
+}
+
+/**
+ * Copies the name of the given parameter from program memory to the given 
+ * buffer of PARAM_NAME bytes.
+ * @param name
+ * @param param
+ */
+static void copyName(char *name, const __flash Param *param) {
+    for (uint8_t i = 0; i < PARAM_NAME; i++) {
+        name[i] = param->name[i];
+    }
+}
+
+/**
+ * Returns the parameter with the given name or NULL if there is none.
+ * @param name
+ * @return parameter
+ */
+static const __flash Param * findParam(const char *name) {
+    for (uint8_t i = 0; i < ARRAY_LENGTH(params); i++) {
+        char pname[PARAM_NAME];
+        copyName(pname, &params[i]);
+        if (strcmp(name, pname) == 0) {
+            return &params[i];
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * Returns the value of the given parameter.
+ * @param param
+ * @return value
+ */
+static uint16_t readParam(const __flash Param *param) {
+    uint8_t *field = (uint8_t *)&config + param->offset;
+    if (param->size == 1) {
+        return *field;
+    }
+    
+    return *(uint16_t *)field;
+}
+
+/**
+ * Sets the given parameter to the given value.
+ * @param param
+ * @param value
+ */
+static void writeParam(const __flash Param *param, uint16_t value) {
+    uint8_t *field = (uint8_t *)&config + param->offset;
+    if (param->size == 1) {
+        *field = value;
+    } else {
+        *(uint16_t *)field = value;
+    }
+}
+
+/**
+ * Returns true if all parameters are within their limits, i.e. not from a 
+ * configuration saved by firmware with other parameters or limits.
+ * @return true if within limits
+ */
+static bool isInLimits(void) {
+    for (uint8_t i = 0; i < ARRAY_LENGTH(params); i++) {
+        uint16_t value = readParam(&params[i]);
+        if (value < params[i].min || value > params[i].max) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+void loadConfig(void) {
+    ConfigBlock block;
+    eeprom_read_block(&block, &eeConfig, sizeof (ConfigBlock));
+    if (block.version == CONFIG_VERSION && block.crc == calcCRC(&block)) {
+        Config defaults = config;
+        config = block.config;
+        if (!isInLimits() || !isValid()) {
+            config = defaults;
+        }
+    }
+    derive();
+}
+
+bool getParam(const char *name, uint16_t *value) {
+    const __flash Param *param = findParam(name);
+    if (param == NULL) {
+        return false;
+    }
+    *value = readParam(param);
+    
+    return true;
+}
+
+bool setParam(const char *name, uint16_t value) {
+    const __flash Param *param = findParam(name);
+    if (param == NULL || value < param->min || value > param->max) {
+        return false;
+    }
+    
+    uint16_t old = readParam(param);
+    writeParam(param, value);
+    if (!isValid()) {
+        // would invert the humidity or overflow calculating it
+        writeParam(param, old);
+        return false;
+    }
+    derive();
+    
+    return true;
+}
+
+void forEachParam(void (*print)(const char *name, uint16_t value)) {
+    for (uint8_t i = 0; i < ARRAY_LENGTH(params); i++) {
+        char pname[PARAM_NAME];
+        copyName(pname, &params[i]);
+        print(pname, readParam(&params[i]));
+    }
+}
+
+void saveConfig(void) {
+    ConfigBlock block = {.version = CONFIG_VERSION, .config = config};
+    block.crc = calcCRC(&block);
+    eeprom_update_block(&block, &eeConfig, sizeof (ConfigBlock));
+}
@@ -0,0 +1,127 @@
+/* 
+ * File:   config.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:02
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Measure and average temperature and relative humidity every ~32 seconds */
+#define MEASURE_INTS    4
+/* 
+ * Display should not be updated more frequently than once every 180 seconds,
+ * values are added to the history at the same interval
+ */
+#define DISP_UPD_INTS   36
+/* Number of fast updates until a full update is done to avoid ghosting */
+#define DISP_MAX_FAST   9
+/* Minimum change of temperature x10 and humidity to update the display */
+#define DISP_HYST_TMP   1
+#define DISP_HYST_RH    1
+
+/** Version of the layout of the configuration in the EEPROM */
+#define CONFIG_VERSION  3
+
+/**
+ * Parameters that can be changed at runtime and saved to the EEPROM.
+ */
+typedef struct {
+    /** Measure every so many watchdog interrupts. */
+    uint8_t measureInts;
+    /** Update the display every so many watchdog interrupts. */
+    uint8_t dispUpdInts;
+    /** Number of fast updates until a full update is done. */
+    uint8_t dispMaxFast;
+    /** Weight of the exponential weighted moving average as bit shift. */
+    uint8_t ewmaBs;
+    /** Minimum change of temperature x10 to update the display. */
+    uint8_t hystTmpx10;
+    /** Minimum change of relative humidity to update the display. */
+    uint8_t hystRh;
+    /** Chemistry of the batteries, one of CHEM_*. */
+    uint8_t batChem;
+    /** Number of battery cells in series. */
+    uint8_t batCells;
+    /** Display white on black if not 0. */
+    uint8_t darkMode;
+    /** Orientation of the display, one of ORIENT_*. */
+    uint8_t orient;
+    /** Internal reference voltage in millivolts. */
+    uint16_t arefMV;
+    /** ADC value of the humidity sensor at 0%RH. */
+    uint16_t rhADC0;
+    /** ADC value of the humidity sensor at 100%RH. */
+    uint16_t rhADC100;
+    /** Battery cutoff voltage in millivolts. */
+    uint16_t batLowMV;
+    /** Capacity of the batteries in mAh. */
+    uint16_t batMAh;
+} Config;
+
+/**
+ * The configuration as stored in the EEPROM.
+ */
+typedef struct {
+    uint8_t version;
+    Config config;
+    uint16_t crc;
+} ConfigBlock;
+
+/**
+ * Values derived from the configuration, precomputed for the hot paths.
+ */
+typedef struct {
+    /** Relative humidity per ADC step as 12.20 fixed point. */
+    uint32_t rhPerADC;
+    /** Battery cutoff voltage in millivolts divided by 5. */
+    int16_t batLow5;
+} Derived;
+
+/** The current configuration */
+extern Config config;
+
+/** Values derived from the current configuration */
+extern Derived derived;
+
+/**
+ * Loads the configuration from the EEPROM if it has the current version 
+ * and a valid CRC, keeps the defaults otherwise, and derives values 
+ * from it.
+ */
+void loadConfig(void);
+
+/**
+ * Looks up the parameter with the given name and writes its value to 
+ * the given value.
+ * @param name
+ * @param value
+ * @return true if the parameter exists, false otherwise
+ */
+bool getParam(const char *name, uint16_t *value);
+
+/**
+ * Sets the parameter with the given name to the given value if it is 
+ * within the limits of the parameter.
+ * @param name
+ * @param value
+ * @return true if the parameter was set, false otherwise
+ */
+bool setParam(const char *name, uint16_t value);
+
+/**
+ * Calls the given function with the name and value of each parameter.
+ * @param print
+ */
+void forEachParam(void (*print)(const char *name, uint16_t value));
+
+/**
+ * Saves the current configuration with version and CRC to the EEPROM.
+ */
+void saveConfig(void);
+
+#endif /* CONFIG_H */
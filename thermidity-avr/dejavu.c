@@ -793,4 +793,13 @@ const __flash Glyph glyphs[] = {
     {0x00b0, 16, DEGREE_SIGN}
 };
 
-const __flash Font dejaVuFont = {glyphs, ARRAY_LENGTH(glyphs), HEIGHT};
+static const __flash Range ranges[] = {
+    {0x0020, 0x0021, 0},
+    {0x0023, 0x0023, 2},
+    {0x0025, 0x0025, 3},
+    {0x002a, 0x0040, 4},
+    {0x00b0, 0x00b0, 27}
+};
+
+const __flash Font dejaVuFont = {glyphs, ARRAY_LENGTH(glyphs), HEIGHT,
+    ranges, ARRAY_LENGTH(ranges)};
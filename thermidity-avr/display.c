@@ -17,6 +17,50 @@
 #include "sram.h"
 #include "eink.h"
 #include "utils.h"
+#include "timing.h"
+
+#define BAND_BYTES (BAND_LINES * DISPLAY_H_BYTES)
+
+#if !RENDER_BANDED && DISPLAY_BYTES > SRAM_SIZE
+#error "Frame does not fit in SRAM, render in bands"
+#endif
+
+static uint8_t orientation = ORIENT_LANDSCAPE;
+
+/* Band being rendered in on-chip RAM, NULL when rendering to SRAM */
+static uint8_t *band = NULL;
+/* Frame address of the first byte of the band being rendered */
+static uint16_t bandStart = 0;
+
+/**
+ * Writes the given byte to the given frame address, either to the frame 
+ * region of the SRAM if the address is within the frame, or to the band 
+ * being rendered, if the address is within that band.
+ * @param address
+ * @param byte
+ */
+static void frameWrite(uint16_t address, uint8_t byte) {
+    if (band == NULL) {
+        if (address < DISPLAY_BYTES) {
+            sramWrite(sramStart(SRAM_FRAME) + address, byte);
+        }
+    } else if ((uint16_t) (address - bandStart) < BAND_BYTES) {
+        band[address - bandStart] = byte;
+    }
+}
+
+/**
+ * Returns true if the given range of frame addresses intersects with the 
+ * band being rendered or if rendering to SRAM.
+ * @param first
+ * @param last
+ * @return true if the range needs to be written
+ */
+static bool inBand(int16_t first, int16_t last) {
+    return band == NULL || 
+            (last >= (int16_t) bandStart && 
+             first < (int16_t) (bandStart + BAND_BYTES));
+}
 
 /**
  * Writes the given byte at the given index for the given bitmap height
@@ -37,14 +81,63 @@ static void bufferByte(uint16_t index, uint16_t index_mod_height,
         *address += 8 * DISPLAY_H_BYTES + 1;
     }
 
-    sramWrite(*address, byte);
+    frameWrite(*address, byte);
     *address -= DISPLAY_H_BYTES;
 }
 
 /**
  * Writes the given bitmap stored in program memory with the given width  
- * and height to the given row and column to SRAM. Width and height must be 
- * multiples of 8.
+ * and height to the given row and column to SRAM or the band being rendered
+ * in portrait orientation, where the bitmap is written row by row as is, 
+ * clipped at the edges of the frame. Width must be a multiple of 8.
+ * @param row (8 pixels)
+ * @param col (8 pixels)
+ * @param bitmap
+ * @param width
+ * @param height
+ */
+static void bufferBitmapPortrait(row_t row, col_t col,
+                                 const __flash uint8_t *bitmap,
+                                 width_t width, height_t height) {
+    uint8_t bytes = width / 8;
+    uint8_t x = col / 8;
+    if (x >= DISPLAY_H_BYTES) {
+        return;
+    }
+    uint8_t visible = bytes < DISPLAY_H_BYTES - x ? bytes : DISPLAY_H_BYTES - x;
+    uint16_t line = row * 8;
+    
+    if (band != NULL) {
+        for (height_t y = 0; y < height && line < DISPLAY_WIDTH; y++, line++) {
+            uint16_t address = line * DISPLAY_H_BYTES + x;
+            if ((uint16_t) (address - bandStart) < BAND_BYTES) {
+                for (uint8_t i = 0; i < visible; i++) {
+                    band[address - bandStart + i] = bitmap[i];
+                }
+            }
+            bitmap += bytes;
+        }
+        
+        return;
+    }
+    
+    sramWriteStatus(SRAM_SEQU);
+    
+    for (height_t y = 0; y < height && line < DISPLAY_WIDTH; y++, line++) {
+        spiBegin(SPI_SRAM);
+        sramInitWrite(sramStart(SRAM_FRAME) + line * DISPLAY_H_BYTES + x);
+        transmitFlash(bitmap, visible);
+        spiEnd(SPI_SRAM);
+        bitmap += bytes;
+    }
+    
+    sramWriteStatus(SRAM_BYTE);
+}
+
+/**
+ * Writes the given bitmap stored in program memory with the given width  
+ * and height to the given row and column to SRAM or the band being rendered.
+ * Width and height must be multiples of 8.
  * @param row (8 pixels)
  * @param col (1 pixel)
  * @param bitmap
@@ -54,8 +147,19 @@ static void bufferByte(uint16_t index, uint16_t index_mod_height,
 static void bufferBitmap(row_t row, col_t col,
                          const __flash uint8_t *bitmap,
                          width_t width, height_t height) {
+    if (orientation == ORIENT_PORTRAIT) {
+        bufferBitmapPortrait(row, col, bitmap, width, height);
+        return;
+    }
+    
     uint16_t size = width * height / 8;
-    uint16_t origin = DISPLAY_WIDTH * DISPLAY_H_BYTES + row - col * DISPLAY_H_BYTES;
+    uint16_t origin = DISPLAY_BYTES + row - col * DISPLAY_H_BYTES;
+    
+    // skip rotating a bitmap that is not within the band being rendered
+    if (!inBand(origin - (width - 1) * DISPLAY_H_BYTES, 
+                origin + height / 8 - 1)) {
+        return;
+    }
 
     // rotate each 8 x 8 pixel 90° clockwise and flip horizontally
     uint8_t rotated[8];
@@ -101,39 +205,207 @@ static void bufferBitmap(row_t row, col_t col,
     }
 }
 
+/**
+ * Writes the given number of bytes to the given column starting at the 
+ * given row, sequentially in SRAM, which must be in sequential mode, or to 
+ * the band being rendered.
+ * @param row (8 pixels)
+ * @param col (1 pixel)
+ * @param bytes
+ * @param count
+ */
+static void writeColumn(row_t row, col_t col, const uint8_t *bytes, uint8_t count) {
+    uint16_t address = DISPLAY_BYTES + row - col * DISPLAY_H_BYTES;
+    if (address + count > DISPLAY_BYTES) {
+        return;
+    }
+    
+    if (band != NULL) {
+        for (uint8_t i = 0; i < count; i++) {
+            if ((uint16_t) (address + i - bandStart) < BAND_BYTES) {
+                band[address + i - bandStart] = bytes[i];
+            }
+        }
+        
+        return;
+    }
+    
+    spiBegin(SPI_SRAM);
+    sramInitWrite(sramStart(SRAM_FRAME) + address);
+    transmitBytes(bytes, count);
+    spiEnd(SPI_SRAM);
+}
+
+/**
+ * Sets the bits of the given pixel run from y0 to y1 in the given column
+ * bytes, the top pixel of a byte being the most significant bit.
+ * @param bytes
+ * @param y0
+ * @param y1
+ */
+static void setRun(uint8_t *bytes, uint8_t y0, uint8_t y1) {
+    for (uint8_t y = y0; y <= y1; y++) {
+        bytes[y >> 3] |= 0x80 >> (y & 0x07);
+    }
+}
+
+/**
+ * Returns the level of the given value in the range of the given graph.
+ * @param graph
+ * @param value
+ * @return level
+ */
+static uint8_t graphLevel(const Graph *graph, int16_t value) {
+    uint16_t range = graph->max - graph->min;
+    if (range == 0) {
+        return GRAPH_LEVEL_MAX / 2;
+    }
+    
+    return (uint32_t) (graph->max - value) * GRAPH_LEVEL_MAX / range;
+}
+
+/**
+ * Reads all values of the given graph to find their minimum and maximum
+ * and scales them to that range again.
+ * @param graph
+ */
+static void graphRescale(Graph *graph) {
+    uint8_t length = graph->rewind();
+    if (length > GRAPH_WIDTH) {
+        length = GRAPH_WIDTH;
+    }
+    graph->min = INT16_MAX;
+    graph->max = INT16_MIN;
+    for (uint8_t i = 0; i < length; i++) {
+        int16_t value = graph->next();
+        if (value < graph->min) graph->min = value;
+        if (value > graph->max) graph->max = value;
+    }
+    
+    graph->rewind();
+    for (uint8_t i = 0; i < length; i++) {
+        graph->levels[i] = graphLevel(graph, graph->next());
+    }
+    graph->head = 0;
+    graph->length = length;
+}
+
+void graphAdd(Graph *graph, int16_t value) {
+    bool full = graph->length == GRAPH_WIDTH;
+    uint8_t dropped = graph->levels[graph->head];
+    if (graph->length == 0 || value < graph->min || value > graph->max ||
+            (full && (dropped == 0 || dropped == GRAPH_LEVEL_MAX))) {
+        // the range changes, or may change with the oldest value dropped
+        graphRescale(graph);
+        return;
+    }
+    
+    uint8_t level = graphLevel(graph, value);
+    if (full) {
+        graph->levels[graph->head] = level;
+        graph->head = (graph->head + 1) % GRAPH_WIDTH;
+    } else {
+        graph->levels[(graph->head + graph->length++) % GRAPH_WIDTH] = level;
+    }
+}
+
+void writeGraph(row_t row, col_t col, uint8_t rows, const Graph *graph) {
+    if (orientation != ORIENT_LANDSCAPE || rows == 0) {
+        return;
+    }
+    if (rows > GRAPH_MAX_ROWS) {
+        rows = GRAPH_MAX_ROWS;
+    }
+    
+    // skip the graph if it is not within the band
+    uint16_t origin = DISPLAY_BYTES + row - col * DISPLAY_H_BYTES;
+    if (!inBand(origin - (GRAPH_WIDTH - 1) * DISPLAY_H_BYTES, 
+                origin + rows - 1)) {
+        return;
+    }
+    
+    uint8_t height = rows * 8 - 1;
+    
+    if (band == NULL) {
+        sramWriteStatus(SRAM_SEQU);
+    }
+    
+    // columns without value stay empty, the newest column is the rightmost
+    uint8_t empty = GRAPH_WIDTH - graph->length;
+    uint8_t prev = 0;
+    for (uint8_t x = 0; x < GRAPH_WIDTH; x++) {
+        uint8_t bytes[GRAPH_MAX_ROWS];
+        memset(bytes, 0, rows);
+        
+        if (x >= empty) {
+            uint8_t level = graph->levels[(graph->head + x - empty) % GRAPH_WIDTH];
+            uint8_t y = (uint16_t) level * height / GRAPH_LEVEL_MAX;
+            if (x == empty) {
+                prev = y;
+            }
+            setRun(bytes, y < prev ? y : prev, y < prev ? prev : y);
+            prev = y;
+        }
+        
+        writeColumn(row, col + x, bytes, rows);
+    }
+    
+    if (band == NULL) {
+        sramWriteStatus(SRAM_BYTE);
+    }
+}
+
+void setOrientation(uint8_t orient) {
+    orientation = orient;
+}
+
 void sramToDisplay(void) {
-    uint16_t bytes = DISPLAY_WIDTH * DISPLAY_H_BYTES;
+    uint16_t bytes = DISPLAY_BYTES;
     
     sramWriteStatus(SRAM_SEQU);
     
-    sramSel();
-    sramInitRead(0x0);
+    spiBegin(SPI_SRAM);
+    sramInitRead(sramStart(SRAM_FRAME));
     
+#if DISPLAY_MSPIM
+    // read the next byte from SRAM via SPI while writing the current one 
+    // to display via MSPIM
+    spiBegin(SPI_DISPLAY);
+    displayCmd(WRITE_RAM_BW);
+    displaySetData();
+    displayRelay(bytes);
+    spiEnd(SPI_DISPLAY);
+#else
+    // SRAM and display share the same SPI profile so both can be selected
     displaySel();
     displaySetCmd();
     uint8_t byte = transmit(WRITE_RAM_BW);
     displaySetData();
+    // the display inverts the image data unless in dark mode
     for (uint16_t i = 0; i < bytes; i++) {
-        // remove negation for dark mode :)
-        byte = transmit(~byte);
+        byte = transmit(byte);
     }
     displayDes();
+#endif
     
-    sramDes();
+    spiEnd(SPI_SRAM);
     sramWriteStatus(SRAM_BYTE);
 }
 
 void setFrame(uint8_t byte) {
-    uint16_t bytes = DISPLAY_WIDTH * DISPLAY_H_BYTES;
+    uint16_t bytes = DISPLAY_BYTES;
+    
+    if (band != NULL) {
+        memset(band, byte, BAND_BYTES);
+        return;
+    }
     
     sramWriteStatus(SRAM_SEQU);
     
-    sramSel();
-    sramInitWrite(0x0);
-    for (uint16_t i = 0; i < bytes; i++) {
-        transmit(byte);
-    }
-    sramDes();
+    spiBegin(SPI_SRAM);
+    sramInitWrite(sramStart(SRAM_FRAME));
+    transmitRepeat(byte, bytes);
+    spiEnd(SPI_SRAM);
     sramWriteStatus(SRAM_BYTE);
 }
 
@@ -152,25 +424,57 @@ width_t writeGlyph(row_t row, col_t col, const __flash Font *font, code_t code)
 }
 
 void writeString(row_t row, col_t col, const __flash Font *font, const char *string) {
-    uint8_t offset = 0;
-    for (; *string != '\0'; string++) {
-        uint8_t c = (uint8_t) *string;
-        if (c == 194) {
-            // multibyte
-        } else if (c == 195) {
-            // multibyte, add 64 to get code point
-            offset = 64;
-        } else {
-            code_t code = c + offset;
-            col += writeGlyph(row, col, font, code);
-            offset = 0;
+    Utf8State state = {0};
+    while (*string != '\0') {
+        if (decodeUtf8(&state, (uint8_t) *string)) {
+            col += writeGlyph(row, col, font, state.code);
         }
+        if (!state.again) {
+            string++;
+        }
+    }
+    if (state.pending > 0) {
+        // string ends with a truncated sequence
+        writeGlyph(row, col, font, CODE_INVALID);
     }
 }
 
 void doDisplay(bool fast) {
     initDisplay(fast);
     resetAddressCounter();
+    PHASE_BEGIN();
     sramToDisplay();
+    PHASE_END(PHASE_TRANSFER);
+    updateDisplay(fast);
+}
+
+void doDisplayBanded(void (*draw)(void), bool fast) {
+    uint8_t buf[BAND_BYTES];
+    
+    initDisplay(fast);
+    resetAddressCounter();
+    
+    band = buf;
+    spiBegin(SPI_DISPLAY);
+    displayCmd(WRITE_RAM_BW);
+    for (bandStart = 0; bandStart < DISPLAY_BYTES; bandStart += BAND_BYTES) {
+        memset(buf, 0x00, BAND_BYTES);
+        PHASE_BEGIN();
+        draw();
+        PHASE_END(PHASE_RENDER);
+        uint16_t bytes = DISPLAY_BYTES - bandStart;
+        if (bytes > BAND_BYTES) {
+            bytes = BAND_BYTES;
+        }
+        // drawing to the band does not use SPI so the display can stay selected
+        PHASE_BEGIN();
+        displaySetData();
+        displayTransmitBytes(buf, bytes);
+        PHASE_END(PHASE_TRANSFER);
+    }
+    spiEnd(SPI_DISPLAY);
+    band = NULL;
+    bandStart = 0;
+    
     updateDisplay(fast);
 }
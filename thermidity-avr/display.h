@@ -11,14 +11,92 @@
 #include "types.h"
 #include "bitmaps.h"
 #include "font.h"
+#include "eink.h"
+#include "sram.h"
+
+/** 
+ * Landscape orientation, DISPLAY_WIDTH x DISPLAY_HEIGHT pixels, the image 
+ * data is rotated 
+ */
+#define ORIENT_LANDSCAPE    0
+/** 
+ * Portrait orientation, DISPLAY_HEIGHT x DISPLAY_WIDTH pixels with the 
+ * display rotated 90° counter-clockwise, the image data is written row by 
+ * row as is 
+ */
+#define ORIENT_PORTRAIT     1
+
+/** 
+ * Render in bands in on-chip RAM directly to the display, bypassing SRAM, 
+ * by default only if the frame does not fit in SRAM
+ */
+#ifndef RENDER_BANDED
+#define RENDER_BANDED       (DISPLAY_BYTES > SRAM_SIZE)
+#endif
+/** Number of display lines (columns in landscape) of a band, ~256 bytes */
+#ifndef BAND_LINES
+#define BAND_LINES          (256 / DISPLAY_H_BYTES)
+#endif
+
+/** Width of a graph in pixels, one column per value */
+#ifndef GRAPH_WIDTH
+#define GRAPH_WIDTH         96
+#endif
+/** Maximum height of a graph in rows of 8 pixels */
+#define GRAPH_MAX_ROWS      8
+
+/** Highest level a value of a graph is scaled to, the level of its minimum */
+#define GRAPH_LEVEL_MAX     255
+
+/**
+ * A graph of the most recent GRAPH_WIDTH values, kept as levels scaled to 
+ * their minimum and maximum so a new value is shifted in without reading
+ * the others again. The values are only read from where they are stored 
+ * when the minimum or maximum changes.
+ */
+typedef struct {
+    /** 
+     * Starts reading with the oldest of the most recent GRAPH_WIDTH values 
+     * and returns the number of values.
+     */
+    uint8_t (*rewind)(void);
+    /** Returns the next value. */
+    int16_t (*next)(void);
+    /** Levels of the values, 0 being the maximum, a ring buffer. */
+    uint8_t levels[GRAPH_WIDTH];
+    /** Index of the oldest level. */
+    uint8_t head;
+    /** Number of levels. */
+    uint8_t length;
+    /** Minimum and maximum of the values. */
+    int16_t min;
+    int16_t max;
+} Graph;
+
+/**
+ * Shifts the given value, the newest one that can be read from the given 
+ * graph, into the graph, dropping the oldest one if it is full. Reads all
+ * values again to rescale the graph if the minimum or maximum changes.
+ * @param graph
+ * @param value
+ */
+void graphAdd(Graph *graph, int16_t value);
+
+/**
+ * Sets the orientation in which bitmaps and glyphs are written to the
+ * frame, ORIENT_LANDSCAPE (default) or ORIENT_PORTRAIT. In portrait 
+ * orientation, the column must be a multiple of 8.
+ * @param orientation
+ */
+void setOrientation(uint8_t orientation);
 
 /**
- * Copies image data from SRAM to display.
+ * Copies image data from the frame region of the SRAM to display as is.
  */
 void sramToDisplay(void);
 
 /**
- * Fills the frame (SRAM) with the given byte, i.e. 0x00 for all white
+ * Fills the frame (SRAM frame region) with the given byte, i.e. 0x00 for all white
  * and 0xff for all black.
  * @param byte
  */
@@ -35,7 +113,7 @@ void setFrame(uint8_t byte);
 width_t writeBitmap(row_t row, col_t col, uint16_t index);
 
 /**
- * Writes the glyph with the given pseudo UTF-8 code point with the given
+ * Writes the glyph with the given Unicode code point with the given
  * font to the given row and column and returns the width of the glyph.
  * @param row (8 pixels)
  * @param col (1 pixel)
@@ -46,7 +124,21 @@ width_t writeBitmap(row_t row, col_t col, uint16_t index);
 width_t writeGlyph(row_t row, col_t col, const __flash Font *font, code_t code);
 
 /**
- * Writes the given string with the given font to the given row and column.
+ * Writes the given graph with the given number of rows to the given row and
+ * column, scaled to the minimum and maximum value, as one vertical run of 
+ * pixels per column connecting it to its predecessor, the newest value 
+ * being the rightmost column. Each column is written in one go, overwriting
+ * what is in the area of the graph. Landscape only.
+ * @param row (8 pixels)
+ * @param col (1 pixel)
+ * @param rows (8 pixels)
+ * @param graph
+ */
+void writeGraph(row_t row, col_t col, uint8_t rows, const Graph *graph);
+
+/**
+ * Writes the given UTF-8 encoded string with the given font to the given 
+ * row and column.
  * @param row (8 pixels)
  * @param col (1 pixel)
  * @param font
@@ -60,4 +152,16 @@ void writeString(row_t row, col_t col, const __flash Font *font, const char *str
  */
 void doDisplay(bool fast);
 
+/**
+ * Initializes the display, resets the address counter, renders the frame
+ * in bands of BAND_LINES lines in on-chip RAM, writing each band directly 
+ * to the display, and updates it, either in fast or full update mode.
+ * The given function is called once for each band and must draw the 
+ * complete frame with setFrame(), writeBitmap(), writeGlyph() and 
+ * writeString(), which write only what is within the current band.
+ * @param draw
+ * @param fast
+ */
+void doDisplayBanded(void (*draw)(void), bool fast);
+
 #endif /* DISPLAY_H */
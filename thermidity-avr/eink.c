@@ -15,6 +15,87 @@
 #include "pins.h"
 #include "sram.h"
 #include "spi.h"
+#include "utils.h"
+#include "timing.h"
+
+/* Flags in the upper bits of the argument count of a sequence command */
+#define SEQ_BUSY    0x80 // wait until the display is no longer busy
+#define SEQ_DELAY   0x40 // wait 10 ms
+#define SEQ_HOOK    0x20 // call the update hook before waiting
+#define SEQ_ARGC    0x0f
+
+/*
+ * Command sequences, each command followed by its argument count with 
+ * flags and the arguments.
+ */
+
+/* 2. Set Initial Configuration, 3. Send Initialization Code */
+static const __flash uint8_t initSeq[] = {
+    // - SW Reset by Command 0x12
+    // - Wait 10ms, datasheet mentions BUSY is high during reset
+    SW_RESET, 0 | SEQ_BUSY | SEQ_DELAY,
+    // - Set gate driver output by Command 0x01
+    DRIVER_OUTPUT_CONTROL, 3, 
+        (DISPLAY_WIDTH - 1) & 0xff, (DISPLAY_WIDTH - 1) >> 8, GATE_SCAN,
+    // - Set display RAM size by Command 0x11, 0x44, 0x45
+    DATA_ENTRY_MODE_SETTING, 1, DATA_ENTRY_MODE,
+    RAM_X_ADDRESS_POSITION, 2, 
+        0x00 + RAM_X_OFFSET, DISPLAY_H_BYTES - 1 + RAM_X_OFFSET,
+    RAM_Y_ADDRESS_POSITION, 4, 
+        RAM_Y_OFFSET & 0xff, RAM_Y_OFFSET >> 8,
+        (DISPLAY_WIDTH - 1 + RAM_Y_OFFSET) & 0xff, 
+        (DISPLAY_WIDTH - 1 + RAM_Y_OFFSET) >> 8,
+    // - Set panel border by Command 0x3C
+    BORDER_WAVEFORM_CONTROL, 1, BORDER_WAVEFORM,
+    // 4. Load Waveform LUT
+    // - Sense temperature by int/ext TS by Command 0x18
+    TEMP_SENSOR_CONTROL, 1, 0x80 // A[7:0] = 80h Internal temperature sensor
+};
+
+/* Load waveform LUT for fast update */
+static const __flash uint8_t fastSeq[] = {
+    // Load temperature value
+    DISPLAY_UPDATE_CONTROL2, 1, 0xb1,
+    MASTER_ACTIVATION, 0 | SEQ_BUSY,
+    // Write temperature value
+    WRITE_TO_TEMP_REGISTER, 2, FAST_TEMP, 0x00,
+    // Load temperature value
+    DISPLAY_UPDATE_CONTROL2, 1, 0x91,
+    MASTER_ACTIVATION, 0 | SEQ_BUSY
+};
+
+/* 5. Write Image and Drive Display Panel */
+static const __flash uint8_t resetSeq[] = {
+    // - Write image data in RAM by Command 0x4E, 0x4F, 0x24, 0x26
+    RAM_X_ADDRESS_COUNTER, 1, RAM_X_OFFSET,
+    RAM_Y_ADDRESS_COUNTER, 2, RAM_Y_OFFSET & 0xff, RAM_Y_OFFSET >> 8
+};
+
+/*
+ * - Drive display panel by Command 0x22, 0x20
+ * - Wait BUSY Low
+ * 6. Power Off
+ * - Deep sleep by Command 0x10
+ * 0xf4, 0xf5, 0xf6, 0xf7 do full update (DISPLAY mode 1)
+ * 0xfc, 0xfd, 0xfe, 0xff do partial update (DISPLAY mode 2)
+ * 0xc7 does fast update
+ */
+static const __flash uint8_t fullUpdateSeq[] = {
+    DISPLAY_UPDATE_CONTROL2, 1, 0xf4,
+    MASTER_ACTIVATION, 0 | SEQ_HOOK | SEQ_BUSY,
+    DEEP_SLEEP_MODE, 1, 0x03 // Deep Sleep Mode 2 (no need to retain RAM data)
+};
+
+static const __flash uint8_t fastUpdateSeq[] = {
+    DISPLAY_UPDATE_CONTROL2, 1, 0xc7,
+    MASTER_ACTIVATION, 0 | SEQ_HOOK | SEQ_BUSY,
+    DEEP_SLEEP_MODE, 1, 0x03 // Deep Sleep Mode 2 (no need to retain RAM data)
+};
+
+static bool darkMode = false;
+
+/* Called while the display is busy updating */
+static void (*updateHook)(void) = NULL;
 
 /**
  * Does a hardware reset.
@@ -29,25 +110,75 @@ static void hwReset(void) {
  * Waits until the display is no longer busy.
  */
 static void waitBusy(void) {
+    // make sure the last command was shifted out
+    displayFlush();
+    PHASE_BEGIN();
     loop_until_bit_is_clear(PINP_DISP, PIN_BUSY);
+    PHASE_END(PHASE_BUSY);
+}
+
+/**
+ * Sends the commands of the given sequence with the given length to the
+ * selected display, switching D/C only between command and arguments.
+ * @param seq
+ * @param length
+ */
+static void runSequence(const __flash uint8_t *seq, uint8_t length) {
+    const __flash uint8_t *end = seq + length;
+    while (seq < end) {
+        uint8_t cmd = *seq++;
+        uint8_t flags = *seq++;
+        uint8_t argc = flags & SEQ_ARGC;
+        
+        displaySetCmd();
+        displayTransmit(cmd);
+        if (argc > 0) {
+            displaySetData();
+            while (argc-- > 0) {
+                displayTransmit(*seq++);
+            }
+        }
+        
+        if ((flags & SEQ_HOOK) && updateHook != NULL) {
+            // make sure the display got the command and started updating
+            displayFlush();
+            updateHook();
+        }
+        if (flags & SEQ_BUSY) {
+            waitBusy();
+        }
+        if (flags & SEQ_DELAY) {
+            _delay_ms(10);
+        }
+    }
 }
 
 void displaySetCmd(void) {
+    displayFlush();
     PORT_DSPI &= ~(1 << PIN_DC);
 }
 
 void displaySetData(void) {
+    displayFlush();
     PORT_DSPI |= (1 << PIN_DC);
 }
 
 void displayCmd(uint8_t cmd) {
     displaySetCmd();
-    transmit(cmd);
+    displayTransmit(cmd);
 }
 
 void displayData(uint8_t data) {
     displaySetData();
-    transmit(data);
+    displayTransmit(data);
+}
+
+void setDarkMode(bool dark) {
+    darkMode = dark;
+}
+
+void setUpdateHook(void (*hook)(void)) {
+    updateHook = hook;
 }
 
 void initDisplay(bool fast) {
@@ -57,7 +188,7 @@ void initDisplay(bool fast) {
     // VCI already supplied, no need to wait
     // _delay_ms(10);
     
-    displaySel();
+    spiBegin(SPI_DISPLAY);
 
     // 2. Set Initial Configuration
     // board selects 4-wire SPI by pulling BS1 low
@@ -67,61 +198,17 @@ void initDisplay(bool fast) {
     hwReset();
     // _delay_ms(100);
     waitBusy();
-
-    // - SW Reset by Command 0x12
-    displayCmd(SW_RESET);
-
-    // - Wait 10ms
-    waitBusy(); // datasheet mentions BUSY is high during reset
-    _delay_ms(10);
     
-    // 3. Send Initialization Code
-    // - Set gate driver output by Command 0x01
-    displayCmd(DRIVER_OUTPUT_CONTROL);
-    displayData(DISPLAY_WIDTH - 1);
-    displayData((DISPLAY_WIDTH - 1) >> 8);
-    displayData(0x00); // GD=0 [POR], SM=0 [POR], TB = 0 [POR]
+    runSequence(initSeq, ARRAY_LENGTH(initSeq));
     
-    // - Set display RAM size by Command 0x11, 0x44, 0x45
-    displayCmd(DATA_ENTRY_MODE_SETTING);
-    displayData(0x03); // A[2:0] = 011 [POR]
-    
-    displayCmd(RAM_X_ADDRESS_POSITION);
-    displayData(0x00 + RAM_X_OFFSET);
-    displayData(DISPLAY_H_BYTES - 1 + RAM_X_OFFSET);
-    
-    displayCmd(RAM_Y_ADDRESS_POSITION);
-    displayData(0x00);
-    displayData(0x00);
-    displayData(DISPLAY_WIDTH - 1);
-    displayData((DISPLAY_WIDTH - 1) >> 8);
-    
-    // - Set panel border by Command 0x3C
-    displayCmd(BORDER_WAVEFORM_CONTROL);
-    displayData(0x05); // ?
-
-    // 4. Load Waveform LUT
-    // - Sense temperature by int/ext TS by Command 0x18
-    displayCmd(TEMP_SENSOR_CONTROL);
-    displayData(0x80); // A[7:0] = 80h Internal temperature sensor
+    // - Let the display invert the image data (bit set = black) unless in
+    //   dark mode, instead of inverting each byte when writing to RAM
+    displayCmd(DISPLAY_UPDATE_CONTROL1);
+    displayData((darkMode ? BW_RAM_NORMAL : BW_RAM_INVERSE) | RAM_OPTION);
+    displayData(SOURCE_OUTPUT);
     
     if (fast) {
-        // Load temperature value
-        displayCmd(DISPLAY_UPDATE_CONTROL2);
-        displayData(0xb1);
-        displayCmd(MASTER_ACTIVATION);
-        waitBusy();
-
-        // Write temperature value
-        displayCmd(WRITE_TO_TEMP_REGISTER);
-        displayData(0x64);
-        displayData(0x00);
-
-        // Load temperature value
-        displayCmd(DISPLAY_UPDATE_CONTROL2);
-        displayData(0x91);
-        displayCmd(MASTER_ACTIVATION);
-        waitBusy();
+        runSequence(fastSeq, ARRAY_LENGTH(fastSeq));
     }
     
     // done at the end, wait for BUSY low anyway
@@ -129,37 +216,28 @@ void initDisplay(bool fast) {
     // - Wait BUSY Low
     waitBusy();
     
-    displayDes();
+    spiEnd(SPI_DISPLAY);
 }
 
 void resetAddressCounter(void) {
-    displaySel();
-    
-    // 5. Write Image and Drive Display Panel
-    // - Write image data in RAM by Command 0x4E, 0x4F, 0x24, 0x26
-    displayCmd(RAM_X_ADDRESS_COUNTER);
-    displayData(RAM_X_OFFSET);
-    
-    displayCmd(RAM_Y_ADDRESS_COUNTER);
-    displayData(0);
-    displayData(0);
-    
-    displayDes();
+    spiBegin(SPI_DISPLAY);
+    runSequence(resetSeq, ARRAY_LENGTH(resetSeq));
+    spiEnd(SPI_DISPLAY);
 }
 
 void imageWrite(uint8_t data) {
-    displaySel();
+    spiBegin(SPI_DISPLAY);
     
     // 5. Write Image and Drive Display Panel
     // - Write image data in RAM by Command 0x4E, 0x4F, 0x24, 0x26
     displayCmd(WRITE_RAM_BW);
     displayData(data);
     
-    displayDes();
+    spiEnd(SPI_DISPLAY);
 }
 
 void updateDisplay(bool fast) {
-    displaySel();
+    spiBegin(SPI_DISPLAY);
     
     // - Set softstart setting by Command 0x0C
     /*
@@ -168,27 +246,16 @@ void updateDisplay(bool fast) {
     displayData(0x9c); // B[7:0] -> Soft start setting for Phase2 = 9Ch [POR]
     displayData(0x96); // C[7:0] -> Soft start setting for Phase3 = 96h [POR]
     displayData(0x0f); // D[7:0] -> Duration setting = 0Fh [POR]
-    displayDes();
      */
     
-    // - Drive display panel by Command 0x22, 0x20
-    // 0xf4, 0xf5, 0xf6, 0xf7 do full update (DISPLAY mode 1)
-    // 0xfc, 0xfd, 0xfe, 0xff do partial update (DISPLAY mode 2)
-    // 0xc7 does fast update
-    displayCmd(DISPLAY_UPDATE_CONTROL2);
-    displayData(fast ? 0xc7 : 0xf4);
-    displayCmd(MASTER_ACTIVATION);
-    
-    // - Wait BUSY Low
-    waitBusy();
-
-    // 6. Power Off
-    // - Deep sleep by Command 0x10
-    displayCmd(DEEP_SLEEP_MODE);
-    displayData(0x11); // Deep Sleep Mode 2 (no need to retain RAM data)
+    if (fast) {
+        runSequence(fastUpdateSeq, ARRAY_LENGTH(fastUpdateSeq));
+    } else {
+        runSequence(fullUpdateSeq, ARRAY_LENGTH(fullUpdateSeq));
+    }
     
     // - Power OFF
     // see 1. Power On
     
-    displayDes();
-}
\ No newline at end of file
+    spiEnd(SPI_DISPLAY);
+}
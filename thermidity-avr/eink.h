@@ -18,6 +18,7 @@
 #define TEMP_SENSOR_CONTROL         0x18
 #define WRITE_TO_TEMP_REGISTER      0x1a
 #define MASTER_ACTIVATION           0x20
+#define DISPLAY_UPDATE_CONTROL1     0x21
 #define DISPLAY_UPDATE_CONTROL2     0x22
 #define WRITE_RAM_BW                0x24
 #define WRITE_RAM_RED               0x26
@@ -27,10 +28,71 @@
 #define RAM_X_ADDRESS_COUNTER       0x4e
 #define RAM_Y_ADDRESS_COUNTER       0x4f
 
+/** Adafruit 2.13" 250x122, SSD1680 */
+#define PANEL_213       0
+/** 2.9" 296x128, SSD1680 */
+#define PANEL_290       1
+/** 4.2" 400x300, SSD1683 */
+#define PANEL_420       2
+
+#ifndef PANEL
+#define PANEL           PANEL_213
+#endif
+
+/* 
+ * Geometry of the panel, width being the number of gates (display RAM Y), 
+ * height the number of sources (display RAM X), and offsets of the panel 
+ * in display RAM, and the initialization data of its controller:
+ * - RAM_OPTION: Display Update Control 1 A[7:4], red RAM option
+ * - SOURCE_OUTPUT: Display Update Control 1 B[7:0], source output mode
+ * - BORDER_WAVEFORM: Border Waveform Control
+ * - FAST_TEMP: temperature written to load the LUT for fast update
+ */
+#if PANEL == PANEL_290
+#define DISPLAY_WIDTH   296
+#define DISPLAY_HEIGHT  128
+#define RAM_X_OFFSET    0
+#define RAM_Y_OFFSET    0
+#define RAM_OPTION      0x00 // normal red RAM content
+#define SOURCE_OUTPUT   0x00 // B[7] = 0 available source from S0 to S175
+#define BORDER_WAVEFORM 0x05
+#define FAST_TEMP       0x64 // 100°C
+#elif PANEL == PANEL_420
+#define DISPLAY_WIDTH   300
+#define DISPLAY_HEIGHT  400
+#define RAM_X_OFFSET    0
+#define RAM_Y_OFFSET    0
+#define RAM_OPTION      0x40 // bypass red RAM content as 0, BW only
+#define SOURCE_OUTPUT   0x00 // B[7:0] = 00h source from S0 to S399
+#define BORDER_WAVEFORM 0x01
+#define FAST_TEMP       0x5a // 90°C
+#else
 #define DISPLAY_WIDTH   250
 #define DISPLAY_HEIGHT  122
-#define DISPLAY_H_BYTES ((DISPLAY_HEIGHT + 8 - DISPLAY_HEIGHT % 8) >> 3)
 #define RAM_X_OFFSET    1
+#define RAM_Y_OFFSET    0
+#define RAM_OPTION      0x00 // normal red RAM content
+#define SOURCE_OUTPUT   0x00 // B[7] = 0 available source from S0 to S175
+#define BORDER_WAVEFORM 0x05
+#define FAST_TEMP       0x64 // 100°C
+#endif
+
+#define DISPLAY_H_BYTES ((DISPLAY_HEIGHT + 7) >> 3)
+#define DISPLAY_BYTES   (DISPLAY_WIDTH * DISPLAY_H_BYTES)
+
+/** Data entry mode: X increment, Y increment, X direction first [POR] */
+#ifndef DATA_ENTRY_MODE
+#define DATA_ENTRY_MODE 0x03
+#endif
+/** Gate scan: GD=0 first gate G0, SM=0 not interlaced, TB=0 G0 to G295 [POR] */
+#ifndef GATE_SCAN
+#define GATE_SCAN       0x00
+#endif
+
+/** Display BW RAM content as is, i.e. bit set = white */
+#define BW_RAM_NORMAL   0x00
+/** Display BW RAM content inverted, i.e. bit set = black */
+#define BW_RAM_INVERSE  0x08
 
 /**
  * Sets display to send a command.
@@ -52,6 +114,22 @@ void displayCmd(uint8_t cmd);
  */
 void displayData(uint8_t data);
 
+/**
+ * Sets dark mode, displaying white on black instead of black on white,
+ * which is done by the display when updating, so the image data needs no 
+ * inversion. Takes effect with the next initialization of the display.
+ * @param dark
+ */
+void setDarkMode(bool dark);
+
+/**
+ * Sets a function to be called once with each update, while the display 
+ * is busy driving the panel and draws the most current, i.e. to measure 
+ * the battery voltage under load.
+ * @param hook
+ */
+void setUpdateHook(void (*hook)(void));
+
 /**
  * Resets the display and initializes it either for fast or full update.
  */
@@ -63,7 +141,8 @@ void initDisplay(bool fast);
 void resetAddressCounter(void);
 
 /**
- * Appends the given 8 pixels (0 = Black, 1 = White) to display RAM.
+ * Appends the given 8 pixels (0 = White, 1 = Black unless in dark mode)
+ * to display RAM.
  * @param data
  */
 void imageWrite(uint8_t data);
@@ -0,0 +1,321 @@
+/* 
+ * File:   fat.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:58
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "fat.h"
+#include "sdcard.h"
+
+/* Smallest number of clusters of FAT16 and FAT32 */
+#define FAT16_CLUSTERS  4085
+#define FAT32_CLUSTERS  65525
+
+/* Directory entry attributes */
+#define ATTR_VOLUME_ID  0x08
+#define ATTR_DIRECTORY  0x10
+
+/* Geometry of the mounted volume */
+static bool fat32;
+static uint8_t secPerClus;
+static uint32_t fatStart;
+static uint32_t rootStart;
+static uint16_t rootBlocks;
+static uint32_t rootClus;
+static uint32_t dataStart;
+
+/* First cluster and size in blocks of the log file, 0 if not found */
+static uint32_t logClus = 0;
+static uint32_t logBlocks = 0;
+
+/* Cluster, block in the cluster and number of blocks left to write */
+static uint32_t cluster;
+static uint8_t block;
+static uint32_t left;
+
+/* Block written last before the one to write, 0 if none */
+static uint32_t prevBlock = 0;
+
+/**
+ * Returns the little endian 16-bit value at the given offset in the buffer.
+ * @param buf
+ * @param offset
+ * @return value
+ */
+static uint16_t le16(const uint8_t *buf, uint16_t offset) {
+    return buf[offset] | ((uint16_t) buf[offset + 1] << 8);
+}
+
+/**
+ * Returns the little endian 32-bit value at the given offset in the buffer.
+ * @param buf
+ * @param offset
+ * @return value
+ */
+static uint32_t le32(const uint8_t *buf, uint16_t offset) {
+    return le16(buf, offset) | ((uint32_t) le16(buf, offset + 2) << 16);
+}
+
+/**
+ * Returns the first block of the given cluster.
+ * @param clus
+ * @return block
+ */
+static uint32_t clusterBlock(uint32_t clus) {
+    return dataStart + (clus - 2) * secPerClus;
+}
+
+/**
+ * Looks up the cluster following the given one in the FAT.
+ * @param clus
+ * @return next cluster, 0 at the end of the chain or on error
+ */
+static uint32_t nextCluster(uint32_t clus) {
+    uint8_t size = fat32 ? 4 : 2;
+    uint16_t perBlock = SD_BLOCK / size;
+    uint8_t entry[4];
+    if (!sdReadPart(fatStart + clus / perBlock, clus % perBlock * size, 
+            entry, size)) {
+        return 0;
+    }
+    
+    if (fat32) {
+        uint32_t next = le32(entry, 0) & 0x0fffffff;
+        return next >= 2 && next < 0x0ffffff8 ? next : 0;
+    } else {
+        uint16_t next = le16(entry, 0);
+        return next >= 2 && next < 0xfff8 ? next : 0;
+    }
+}
+
+/**
+ * Returns true if the block with the given number is written, which is 
+ * the case if it does not start with a zero byte as the log file is text.
+ * A block that cannot be read is assumed to be written so it is never 
+ * overwritten.
+ * @param blk
+ * @return true if written
+ */
+static bool isWritten(uint32_t blk) {
+    uint8_t first = 0xff;
+    sdReadPart(blk, 0, &first, 1);
+    
+    return first != 0x00;
+}
+
+/**
+ * Calculates the geometry of the volume starting at the given block from 
+ * the given BIOS parameter block.
+ * @param volume
+ * @param bpb
+ * @return true if it is a supported FAT volume, false otherwise
+ */
+static bool readVolume(uint32_t volume, const uint8_t *bpb) {
+    if (le16(bpb, BPB_BYTS_PER_SEC) != SD_BLOCK) {
+        return false;
+    }
+    
+    secPerClus = bpb[BPB_SEC_PER_CLUS];
+    uint32_t fatSize = le16(bpb, BPB_FAT_SZ16);
+    if (fatSize == 0) {
+        fatSize = le32(bpb, BPB_FAT_SZ32);
+    }
+    uint32_t totSec = le16(bpb, BPB_TOT_SEC16);
+    if (totSec == 0) {
+        totSec = le32(bpb, BPB_TOT_SEC32);
+    }
+    if (secPerClus == 0 || fatSize == 0) {
+        return false;
+    }
+    
+    fatStart = volume + le16(bpb, BPB_RSVD_SEC_CNT);
+    rootStart = fatStart + bpb[BPB_NUM_FATS] * fatSize;
+    rootBlocks = (le16(bpb, BPB_ROOT_ENT_CNT) * DIR_ENTRY + SD_BLOCK - 1) / SD_BLOCK;
+    rootClus = le32(bpb, BPB_ROOT_CLUS);
+    dataStart = rootStart + rootBlocks;
+    
+    uint32_t clusters = (totSec - (dataStart - volume)) / secPerClus;
+    fat32 = clusters >= FAT32_CLUSTERS;
+    
+    // FAT12 is not supported
+    return clusters >= FAT16_CLUSTERS;
+}
+
+/**
+ * Looks up the log file in the directory block with the given number,
+ * reading it entry by entry.
+ * @param blk
+ * @return true if the end of the directory was reached or on error, 
+ *         false otherwise
+ */
+static bool findLog(uint32_t blk) {
+    if (!sdReadBegin(blk)) {
+        return true;
+    }
+    
+    bool end = false;
+    for (uint16_t i = 0; i < SD_BLOCK && !end; i += DIR_ENTRY) {
+        uint8_t entry[DIR_ENTRY];
+        sdRead(entry, DIR_ENTRY);
+        if (entry[DIR_NAME] == 0x00) {
+            end = true;
+        } else if (entry[DIR_ATTR] & (ATTR_VOLUME_ID | ATTR_DIRECTORY)) {
+            // also skips long file name entries
+            continue;
+        } else if (memcmp(entry + DIR_NAME, FAT_LOG_NAME, 11) == 0) {
+            logClus = ((uint32_t) le16(entry, DIR_FST_CLUS_HI) << 16) | 
+                    le16(entry, DIR_FST_CLUS_LO);
+            logBlocks = le32(entry, DIR_FILE_SIZE) / SD_BLOCK;
+            end = true;
+        }
+    }
+    sdReadEnd();
+    
+    return end;
+}
+
+/**
+ * Looks up the log file in the root directory, a fixed region with FAT16 
+ * and a cluster chain with FAT32.
+ */
+static void findRoot(void) {
+    logClus = 0;
+    logBlocks = 0;
+    
+    if (!fat32) {
+        for (uint16_t i = 0; i < rootBlocks; i++) {
+            if (findLog(rootStart + i)) {
+                return;
+            }
+        }
+        return;
+    }
+    
+    for (uint32_t clus = rootClus; clus != 0; clus = nextCluster(clus)) {
+        for (uint8_t i = 0; i < secPerClus; i++) {
+            if (findLog(clusterBlock(clus) + i)) {
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * Looks up the first block of the log file not written yet, skipping 
+ * clusters whose last block is already written.
+ */
+static void seekLog(void) {
+    cluster = logClus;
+    block = 0;
+    left = logBlocks;
+    prevBlock = 0;
+    
+    while (left > 0 && cluster != 0) {
+        uint8_t blocks = left < secPerClus ? left : secPerClus;
+        uint32_t first = clusterBlock(cluster);
+        if (isWritten(first + blocks - 1)) {
+            prevBlock = first + blocks - 1;
+            left -= blocks;
+            cluster = left > 0 ? nextCluster(cluster) : 0;
+            continue;
+        }
+        for (; block < blocks; block++, left--) {
+            if (!isWritten(first + block)) {
+                return;
+            }
+            prevBlock = first + block;
+        }
+    }
+    
+    // full or broken chain
+    left = 0;
+}
+
+/**
+ * Returns true if the block written last is still written and the block 
+ * to write next is not, i.e. the log file was written up to the same 
+ * block as when it was last mounted.
+ * @return true if the position to write is still valid
+ */
+static bool checkLog(void) {
+    if (prevBlock != 0 && !isWritten(prevBlock)) {
+        return false;
+    }
+    if (left > 0 && cluster != 0 && isWritten(clusterBlock(cluster) + block)) {
+        return false;
+    }
+    
+    return true;
+}
+
+bool fatMount(void) {
+    uint32_t prevClus = logClus;
+    uint32_t prevBlocks = logBlocks;
+    
+    // block 0 is either the volume boot record or the master boot record
+    uint8_t bpb[BPB_SIZE];
+    uint8_t lba[4];
+    uint8_t signature[2];
+    if (!sdReadBegin(0)) {
+        return false;
+    }
+    sdRead(bpb, sizeof (bpb));
+    sdRead(NULL, MBR_PARTITION + MBR_PART_LBA - sizeof (bpb));
+    sdRead(lba, sizeof (lba));
+    sdRead(NULL, MBR_SIGNATURE - MBR_PARTITION - MBR_PART_LBA - sizeof (lba));
+    sdRead(signature, sizeof (signature));
+    sdReadEnd();
+    if (le16(signature, 0) != 0xaa55) {
+        return false;
+    }
+    
+    bool vbr = (bpb[0] == 0xeb || bpb[0] == 0xe9) && 
+            le16(bpb, BPB_BYTS_PER_SEC) == SD_BLOCK;
+    uint32_t volume = 0;
+    if (!vbr) {
+        volume = le32(lba, 0);
+        if (!sdReadPart(volume, 0, bpb, sizeof (bpb))) {
+            return false;
+        }
+    }
+    if (!readVolume(volume, bpb)) {
+        return false;
+    }
+    
+    findRoot();
+    if (logClus == 0 || logBlocks == 0) {
+        return false;
+    }
+    // the card may have been swapped with one with the same layout
+    if (logClus != prevClus || logBlocks != prevBlocks || !checkLog()) {
+        seekLog();
+    }
+    
+    return true;
+}
+
+bool fatAppendBegin(void) {
+    if (left == 0 || cluster == 0) {
+        return false;
+    }
+    
+    return sdWriteBegin(clusterBlock(cluster) + block);
+}
+
+bool fatAppendEnd(void) {
+    if (!sdWriteEnd()) {
+        return false;
+    }
+    
+    prevBlock = clusterBlock(cluster) + block;
+    left--;
+    if (++block == secPerClus && left > 0) {
+        block = 0;
+        cluster = nextCluster(cluster);
+    }
+    
+    return true;
+}
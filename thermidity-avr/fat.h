@@ -0,0 +1,72 @@
+/* 
+ * File:   fat.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:58
+ */
+
+#ifndef FAT_H
+#define FAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Name of the log file in the root directory, in 8.3 directory format */
+#define FAT_LOG_NAME    "THERMID LOG"
+
+/** Number of bytes of the BIOS parameter block read */
+#define BPB_SIZE            48
+
+/** Offsets in the BIOS parameter block */
+#define BPB_BYTS_PER_SEC    11
+#define BPB_SEC_PER_CLUS    13
+#define BPB_RSVD_SEC_CNT    14
+#define BPB_NUM_FATS        16
+#define BPB_ROOT_ENT_CNT    17
+#define BPB_TOT_SEC16       19
+#define BPB_FAT_SZ16        22
+#define BPB_TOT_SEC32       32
+#define BPB_FAT_SZ32        36
+#define BPB_ROOT_CLUS       44
+
+/** Offsets in the master boot record */
+#define MBR_PARTITION       446
+#define MBR_PART_LBA        8
+#define MBR_SIGNATURE       510
+
+/** Offsets in a directory entry */
+#define DIR_NAME            0
+#define DIR_ATTR            11
+#define DIR_FST_CLUS_HI     20
+#define DIR_FST_CLUS_LO     26
+#define DIR_FILE_SIZE       28
+#define DIR_ENTRY           32
+
+/**
+ * Mounts the FAT16 or FAT32 file system on the SD card and looks up the 
+ * log file FAT_LOG_NAME in its root directory. The log file must have been
+ * created beforehand with the maximum size and filled with zeros, as only
+ * its data blocks are written, leaving the FAT and directory untouched. 
+ * The first block not yet written is looked up again unless the one after
+ * the last written block still is, i.e. the card was not swapped or was 
+ * swapped with one written up to the same block.
+ * @return true if the log file was found, false otherwise
+ */
+bool fatMount(void);
+
+/**
+ * Starts writing the next unwritten block of the log file, which is to be
+ * transmitted with sdWrite().
+ * @return true if the block can be written, false if the file is full or
+ *         on error
+ */
+bool fatAppendBegin(void);
+
+/**
+ * Ends writing the block started with fatAppendBegin() and advances to 
+ * the next one if it was written.
+ * @return true if the block was written, false otherwise
+ */
+bool fatAppendEnd(void);
+
+#endif /* FAT_H */
@@ -8,14 +8,42 @@
 #include <stdio.h>
 #include "font.h"
 
-const __flash Glyph* getGlyphAddress(const __flash Font *font, code_t code) {
+/**
+ * Returns the flash address of the glyph at the given code point from the
+ * given font, using its ranges if it has any, or NULL if there is no glyph
+ * for that code point.
+ * @param font
+ * @param code
+ * @return Glyph or NULL
+ */
+static const __flash Glyph* findGlyph(const __flash Font *font, code_t code) {
+    if (font->ranges != NULL) {
+        // binary search over the ranges, which are in ascending order
+        int8_t l = 0;
+        int8_t r = font->rangesLength - 1;
+        
+        while (l <= r) {
+            int8_t m = (l + r) / 2;
+            const __flash Range *range = &font->ranges[m];
+            if (range->last < code) {
+                l = m + 1;
+            } else if (range->first > code) {
+                r = m - 1;
+            } else {
+                // offset of the code point in its range
+                return &font->glyphs[range->index + (code - range->first)];
+            }
+        }
+        
+        return NULL;
+    }
     
     // https://en.wikipedia.org/wiki/Binary_search_algorithm
-    code_t l = 0;
-    code_t r = font->length - 1;
+    int16_t l = 0;
+    int16_t r = font->length - 1;
     
     while (l <= r) {
-        code_t m = (l + r) / 2;
+        int16_t m = (l + r) / 2;
         const __flash Glyph *pglyph = &font->glyphs[m];
         if (pglyph->code < code) {
             l = m + 1;
@@ -26,7 +54,76 @@ const __flash Glyph* getGlyphAddress(const __flash Font *font, code_t code) {
             return pglyph;
         }
     }
+    
+    return NULL;
+}
 
-    // return question mark if unknown code point
-    return getGlyphAddress(font, 0x003f);
+const __flash Glyph* getGlyphAddress(const __flash Font *font, code_t code) {
+    const __flash Glyph *pglyph = findGlyph(font, code);
+    if (pglyph == NULL) {
+        // return question mark if unknown code point
+        pglyph = findGlyph(font, 0x003f);
+    }
+    if (pglyph == NULL) {
+        // font has no question mark either
+        pglyph = &font->glyphs[0];
+    }
+    
+    return pglyph;
+}
+
+bool decodeUtf8(Utf8State *state, uint8_t byte) {
+    state->again = false;
+    if ((byte & 0xc0) == 0x80) {
+        // continuation byte
+        if (state->pending == 0) {
+            // unexpected continuation byte
+            state->code = CODE_INVALID;
+            return true;
+        }
+        state->code = (state->code << 6) | (byte & 0x3f);
+        if (--state->pending > 0) {
+            return false;
+        }
+        if (state->invalid || state->code < state->min ||
+                (state->code >= 0xd800 && state->code <= 0xdfff)) {
+            // overlong or surrogate
+            state->code = CODE_INVALID;
+        }
+        return true;
+    }
+    
+    if (state->pending > 0) {
+        // decode the truncated sequence, then this byte again
+        state->pending = 0;
+        state->code = CODE_INVALID;
+        state->again = true;
+        return true;
+    }
+    
+    state->invalid = false;
+    if (byte < 0x80) {
+        state->code = byte;
+        return true;
+    } 
+    if ((byte & 0xe0) == 0xc0) {
+        state->code = byte & 0x1f;
+        state->min = 0x0080;
+        state->pending = 1;
+    } else if ((byte & 0xf0) == 0xe0) {
+        state->code = byte & 0x0f;
+        state->min = 0x0800;
+        state->pending = 2;
+    } else if ((byte & 0xf8) == 0xf0) {
+        // beyond the Basic Multilingual Plane
+        state->code = 0;
+        state->pending = 3;
+        state->invalid = true;
+    } else {
+        // no valid lead byte
+        state->code = CODE_INVALID;
+        return true;
+    }
+    
+    return false;
 }
@@ -8,13 +8,17 @@
 #ifndef FONT_H
 #define FONT_H
 
+#include <stdbool.h>
 #include "types.h"
 
+/** Code point of the replacement character for undecodable UTF-8 */
+#define CODE_INVALID 0xfffd
+
 /**
- * A glyph with its pseudo UTF-8 code point, width and bitmap.
+ * A glyph with its Unicode code point, width and bitmap.
  */
 typedef struct {
-    /** Pseudo UTF-8 code point of the glyph. */
+    /** Unicode code point of the glyph. */
     const code_t code;
     /** Width of the glyph. */
     const width_t width;
@@ -22,6 +26,20 @@ typedef struct {
     const __flash uint8_t *bitmap;
 } Glyph;
 
+/**
+ * A range of consecutive code points each having a glyph, and the index of
+ * the glyph of the first code point in the glyphs of the font. Together,
+ * the ranges of a font map each of its code points directly to its glyph.
+ */
+typedef struct {
+    /** First code point of this range. */
+    const code_t first;
+    /** Last code point of this range. */
+    const code_t last;
+    /** Index of the glyph of the first code point of this range. */
+    const length_t index;
+} Range;
+
 /**
  * Fonts available here. Since the height is the same for all glyphs,
  * it is stored in the font instead of redundantly in each glyph.
@@ -33,11 +51,33 @@ typedef struct {
     const length_t length;
     /** Height of (the glyphs of) this font. */
     const height_t height;
+    /** Ranges of code points of this font in ascending order, optional. */
+    const __flash Range *ranges;
+    /** Number of ranges of this font, at most 127. */
+    const uint8_t rangesLength;
 } Font;
 
 /**
- * Returns the flash address of the glyph at the given pseudo UTF-8 code
+ * State of decoding an UTF-8 encoded string byte by byte.
+ */
+typedef struct {
+    /** Code point decoded so far. */
+    code_t code;
+    /** Smallest code point the sequence may encode without being overlong. */
+    code_t min;
+    /** Number of continuation bytes still expected. */
+    uint8_t pending;
+    /** If the sequence is malformed or beyond the Basic Multilingual Plane. */
+    bool invalid;
+    /** If the byte was not consumed and must be fed again. */
+    bool again;
+} Utf8State;
+
+/**
+ * Returns the flash address of the glyph at the given Unicode code
  * point, i.e. 0x00f6 for U+00F6 from the given font.
+ * If the font has ranges, the glyph is looked up in these, otherwise a
+ * binary search is done over the glyphs.
  * If there is no glyph for that code point, a question mark is returned.
  * @param font
  * @param code
@@ -45,4 +85,20 @@ typedef struct {
  */
 const __flash Glyph* getGlyphAddress(const __flash Font *font, code_t code);
 
+/**
+ * Feeds the given byte of an UTF-8 encoded string to the given state,
+ * which must be zeroed before the first byte, and returns true if that
+ * byte completed a code point, which then is in state->code. 
+ * Malformed, truncated, overlong and surrogate sequences and code points 
+ * beyond the Basic Multilingual Plane are decoded as CODE_INVALID. 
+ * If a byte truncates an incomplete sequence, CODE_INVALID is decoded for 
+ * that sequence and state->again is set, so the byte must be fed again.
+ * At the end of the string, an incomplete sequence is left if 
+ * state->pending is not 0.
+ * @param state
+ * @param byte
+ * @return true if a code point was decoded
+ */
+bool decodeUtf8(Utf8State *state, uint8_t byte);
+
 #endif /* FONT_H */
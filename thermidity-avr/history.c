@@ -0,0 +1,181 @@
+/* 
+ * File:   history.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:49
+ */
+
+#include <stdio.h>
+#include "history.h"
+#include "sram.h"
+
+/*
+ * The history is a ring buffer of blocks, each starting with a header 
+ * with the absolute values of its first sample and the number of samples 
+ * in the block, followed by the other samples encoded as one byte deltas 
+ * to their predecessor: 
+ * bits 7-4: temperature delta -8..7 (0.1°C)
+ * bits 3-1: humidity delta -4..3 (%)
+ * bit 0: battery voltage dropped by 0.1V
+ * A sample that cannot be delta encoded starts a new block.
+ */
+#define HEADER_TMP_H    0
+#define HEADER_TMP_L    1
+#define HEADER_RH       2
+#define HEADER_BAT      3
+#define HEADER_COUNT    4
+#define HEADER_SIZE     5
+
+#define DELTA_TMP_MIN   -8
+#define DELTA_TMP_MAX   7
+#define DELTA_RH_MIN    -4
+#define DELTA_RH_MAX    3
+
+/* Index of the block being written */
+static uint16_t head = 0;
+/* Number of blocks in use */
+static uint16_t used = 0;
+/* Number of samples in the block being written */
+static uint8_t count = 0;
+/* Number of samples in all blocks */
+static uint16_t length = 0;
+/* Sample added last */
+static Sample last;
+
+/**
+ * Returns the number of blocks fitting in the history region.
+ * @return number of blocks
+ */
+static uint16_t blocks(void) {
+    return sramSize(SRAM_HISTORY) / HISTORY_BLOCK;
+}
+
+/**
+ * Returns the SRAM address of the block with the given index.
+ * @param block
+ * @return address
+ */
+static sramaddr_t blockAddress(uint16_t block) {
+    return sramStart(SRAM_HISTORY) + (sramaddr_t) block * HISTORY_BLOCK;
+}
+
+/**
+ * Starts a new block with the given sample, dropping the oldest block
+ * if all blocks are in use.
+ * @param sample
+ */
+static void startBlock(Sample sample) {
+    uint16_t total = blocks();
+    if (used > 0) {
+        head = (head + 1) % total;
+    }
+    if (used == total) {
+        // drop the oldest block, which is the one to be overwritten
+        length -= sramRead(blockAddress(head) + HEADER_COUNT);
+    } else {
+        used++;
+    }
+    
+    sramaddr_t address = blockAddress(head);
+    sramWrite(address + HEADER_TMP_H, sample.tmpx10 >> 8);
+    sramWrite(address + HEADER_TMP_L, sample.tmpx10);
+    sramWrite(address + HEADER_RH, sample.rh);
+    sramWrite(address + HEADER_BAT, sample.vBatx10);
+    sramWrite(address + HEADER_COUNT, 1);
+    count = 1;
+}
+
+void historyAdd(Sample sample) {
+    if (blocks() == 0) {
+        return;
+    }
+    
+    int16_t dTmp = sample.tmpx10 - last.tmpx10;
+    int8_t dRh = sample.rh - last.rh;
+    int8_t dBat = last.vBatx10 - sample.vBatx10;
+    
+    if (used == 0 || HEADER_SIZE + count > HISTORY_BLOCK ||
+            dTmp < DELTA_TMP_MIN || dTmp > DELTA_TMP_MAX ||
+            dRh < DELTA_RH_MIN || dRh > DELTA_RH_MAX ||
+            dBat < 0 || dBat > 1) {
+        startBlock(sample);
+    } else {
+        sramaddr_t address = blockAddress(head);
+        uint8_t delta = ((dTmp & 0x0f) << 4) | ((dRh & 0x07) << 1) | dBat;
+        sramWrite(address + HEADER_SIZE + count - 1, delta);
+        sramWrite(address + HEADER_COUNT, ++count);
+    }
+    
+    length++;
+    last = sample;
+}
+
+uint16_t historyLength(void) {
+    return length;
+}
+
+void historyIterate(HistoryIterator *iterator) {
+    uint16_t total = blocks();
+    iterator->blocks = used;
+    iterator->block = used == 0 ? 0 : (head + total - (used - 1)) % total;
+    iterator->count = 0;
+    iterator->index = 0;
+}
+
+void historyIterateLast(HistoryIterator *iterator, uint16_t samples) {
+    historyIterate(iterator);
+    if (samples >= length) {
+        return;
+    }
+    
+    // walk back from the newest block to the one with the first sample
+    uint16_t total = blocks();
+    uint16_t block = head;
+    uint16_t newer = count;
+    iterator->blocks = 1;
+    while (newer < samples) {
+        block = (block + total - 1) % total;
+        newer += sramRead(blockAddress(block) + HEADER_COUNT);
+        iterator->blocks++;
+    }
+    iterator->block = block;
+    
+    // skip the older samples in that block
+    Sample sample;
+    for (uint16_t skip = newer - samples; skip > 0; skip--) {
+        historyNext(iterator, &sample);
+    }
+}
+
+bool historyNext(HistoryIterator *iterator, Sample *sample) {
+    if (iterator->index == iterator->count) {
+        if (iterator->blocks == 0) {
+            return false;
+        }
+        if (iterator->index > 0) {
+            // continue with the next block
+            iterator->block = (iterator->block + 1) % blocks();
+        }
+        iterator->blocks--;
+        
+        sramaddr_t address = blockAddress(iterator->block);
+        iterator->sample.tmpx10 = (sramRead(address + HEADER_TMP_H) << 8) | 
+                sramRead(address + HEADER_TMP_L);
+        iterator->sample.rh = sramRead(address + HEADER_RH);
+        iterator->sample.vBatx10 = sramRead(address + HEADER_BAT);
+        iterator->count = sramRead(address + HEADER_COUNT);
+        iterator->index = 1;
+    } else {
+        sramaddr_t address = blockAddress(iterator->block);
+        uint8_t delta = sramRead(address + HEADER_SIZE + iterator->index - 1);
+        // sign extend the temperature and humidity deltas
+        iterator->sample.tmpx10 += (int8_t) delta >> 4;
+        iterator->sample.rh += (int8_t) (delta << 4) >> 5;
+        iterator->sample.vBatx10 -= delta & 0x01;
+        iterator->index++;
+    }
+    
+    *sample = iterator->sample;
+    
+    return true;
+}
@@ -0,0 +1,84 @@
+/* 
+ * File:   history.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:49
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sram.h"
+
+/** Size of a block of samples in the history region of the SRAM */
+#define HISTORY_BLOCK   32
+
+/**
+ * A sample of measured values.
+ */
+typedef struct {
+    /** Temperature in °C multiplied by 10. */
+    int16_t tmpx10;
+    /** Relative humidity in %. */
+    int8_t rh;
+    /** Battery voltage in V multiplied by 10. */
+    int8_t vBatx10;
+} Sample;
+
+/**
+ * Iterates over the samples in the history from oldest to newest.
+ */
+typedef struct {
+    /** Index of the current block. */
+    uint16_t block;
+    /** Number of blocks left including the current one. */
+    uint16_t blocks;
+    /** Number of samples in the current block. */
+    uint8_t count;
+    /** Index of the next sample in the current block. */
+    uint8_t index;
+    /** Sample decoded last. */
+    Sample sample;
+} HistoryIterator;
+
+/**
+ * Adds the given sample to the history in the SRAM history region, 
+ * delta encoded if possible, dropping the oldest block of samples if the
+ * history is full. Does nothing if there is no history region.
+ * @param sample
+ */
+void historyAdd(Sample sample);
+
+/**
+ * Returns the number of samples in the history.
+ * @return number of samples
+ */
+uint16_t historyLength(void);
+
+/**
+ * Initializes the given iterator to start with the oldest sample.
+ * @param iterator
+ */
+void historyIterate(HistoryIterator *iterator);
+
+/**
+ * Initializes the given iterator to start with the oldest of the given 
+ * number of newest samples, or with the oldest sample if there are not 
+ * as many.
+ * @param iterator
+ * @param samples
+ */
+void historyIterateLast(HistoryIterator *iterator, uint16_t samples);
+
+/**
+ * Decodes the next sample of the given iterator into the given sample.
+ * @param iterator
+ * @param sample
+ * @return true if there was a next sample, false otherwise
+ */
+bool historyNext(HistoryIterator *iterator, Sample *sample);
+
+#endif /* HISTORY_H */
+
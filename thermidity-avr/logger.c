@@ -0,0 +1,191 @@
+/* 
+ * File:   logger.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:58
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "logger.h"
+#include "sram.h"
+#include "sdcard.h"
+#include "fat.h"
+
+/*
+ * The log buffer is a ring buffer of samples in the SRAM log region, each
+ * stored as temperature (big endian), humidity and battery voltage. The 
+ * samples are formatted to records only while they are written to the SD 
+ * card, so a record may be split across two blocks.
+ */
+#define SAMPLE_TMP_H    0
+#define SAMPLE_TMP_L    1
+#define SAMPLE_RH       2
+#define SAMPLE_BAT      3
+
+/* Maximum number of samples whose records fill a block */
+#define BLOCK_SAMPLES   (SD_BLOCK / LOG_RECORD_MIN + 2)
+
+/* Index of the oldest sample in the buffer */
+static uint16_t tail = 0;
+/* Number of samples in the buffer */
+static uint16_t count = 0;
+/* Number of samples added since the last attempt to write to the SD card */
+static uint16_t added = 0;
+/* Record number of the oldest sample, to tell the time in the log */
+static uint32_t tailRecord = 0;
+/* Number of bytes of the record of the oldest sample already written */
+static uint8_t written = 0;
+
+/**
+ * Returns the number of samples fitting in the log buffer.
+ * @return capacity
+ */
+static uint16_t capacity(void) {
+    return sramSize(SRAM_LOG) / LOG_SAMPLE;
+}
+
+/**
+ * Returns the SRAM address of the sample with the given index.
+ * @param index
+ * @return address
+ */
+static sramaddr_t sampleAddress(uint16_t index) {
+    return sramStart(SRAM_LOG) + (sramaddr_t) index * LOG_SAMPLE;
+}
+
+/**
+ * Formats the given sample with the given record number as line of comma
+ * separated values to the given buffer of LOG_RECORD bytes and returns 
+ * its length.
+ * @param record
+ * @param sample
+ * @param number
+ * @return length
+ */
+static uint8_t formatRecord(char *record, Sample sample, uint32_t number) {
+    div_t tmp = div(sample.tmpx10, 10);
+    div_t bat = div(sample.vBatx10, 10);
+    int length = snprintf(record, LOG_RECORD, "%lu,%s%d.%d,%d,%d.%d\n",
+            (unsigned long)number, sample.tmpx10 < 0 ? "-" : "", 
+            abs(tmp.quot), abs(tmp.rem), sample.rh, bat.quot, bat.rem);
+    
+    return length < LOG_RECORD ? length : LOG_RECORD - 1;
+}
+
+/**
+ * Reads the oldest samples whose records fill the next block into the 
+ * given buffer of BLOCK_SAMPLES samples and returns their number, or 0 if
+ * there are not enough samples to fill a block.
+ * @param samples
+ * @return number of samples
+ */
+static uint8_t readBlock(Sample *samples) {
+    uint16_t size = capacity();
+    uint16_t length = 0;
+    for (uint8_t i = 0; i < count && i < BLOCK_SAMPLES; i++) {
+        sramaddr_t address = sampleAddress((tail + i) % size);
+        samples[i].tmpx10 = (sramRead(address + SAMPLE_TMP_H) << 8) | 
+                sramRead(address + SAMPLE_TMP_L);
+        samples[i].rh = sramRead(address + SAMPLE_RH);
+        samples[i].vBatx10 = sramRead(address + SAMPLE_BAT);
+        
+        char record[LOG_RECORD];
+        length += formatRecord(record, samples[i], tailRecord + i);
+        if (i == 0) {
+            length -= written;
+        }
+        if (length >= SD_BLOCK) {
+            return i + 1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * Formats the records of the given number of samples and transmits them 
+ * to the block being written, the first one from where it was split, 
+ * until the block is full.
+ * @param samples
+ * @param n
+ * @return number of bytes of the last record written if it was split, 
+ *         0 otherwise
+ */
+static uint8_t writeRecords(const Sample *samples, uint8_t n) {
+    uint16_t free = SD_BLOCK;
+    for (uint8_t i = 0; i < n; i++) {
+        char record[LOG_RECORD];
+        uint8_t length = formatRecord(record, samples[i], tailRecord + i);
+        uint8_t start = i == 0 ? written : 0;
+        uint8_t end = length - start < free ? length : start + free;
+        sdWrite((const uint8_t *)record + start, end - start);
+        free -= end - start;
+        if (end < length) {
+            return end;
+        }
+    }
+    
+    return 0;
+}
+
+void logAdd(Sample sample) {
+    uint16_t size = capacity();
+    if (size == 0) {
+        return;
+    }
+    
+    if (count == size) {
+        // drop the oldest sample, even if its record was partially written
+        tail = (tail + 1) % size;
+        count--;
+        tailRecord++;
+        written = 0;
+    }
+    
+    sramaddr_t address = sampleAddress((tail + count) % size);
+    sramWrite(address + SAMPLE_TMP_H, sample.tmpx10 >> 8);
+    sramWrite(address + SAMPLE_TMP_L, sample.tmpx10);
+    sramWrite(address + SAMPLE_RH, sample.rh);
+    sramWrite(address + SAMPLE_BAT, sample.vBatx10);
+    count++;
+    added++;
+}
+
+bool logPending(void) {
+    // also holds off retrying if the card is missing or the file full
+    return added >= LOG_PENDING;
+}
+
+bool logFlush(void) {
+    added = 0;
+    if (!sdInit() || !fatMount()) {
+        return false;
+    }
+    
+    uint16_t size = capacity();
+    while (true) {
+        // the SRAM and the card share the bus, so the samples of a block 
+        // are read before the card is selected to write it
+        Sample samples[BLOCK_SAMPLES];
+        uint8_t n = readBlock(samples);
+        if (n == 0) {
+            return true;
+        }
+        
+        if (!fatAppendBegin()) {
+            return false;
+        }
+        uint8_t split = writeRecords(samples, n);
+        if (!fatAppendEnd()) {
+            return false;
+        }
+        
+        // the sample with the split record stays in the buffer
+        uint8_t done = split == 0 ? n : n - 1;
+        tail = (tail + done) % size;
+        count -= done;
+        tailRecord += done;
+        written = split;
+    }
+}
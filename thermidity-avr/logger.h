@@ -0,0 +1,69 @@
+/* 
+ * File:   logger.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:58
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "history.h"
+
+/** 
+ * Log measured values to the SD card, with its chip select wired to 
+ * PIN_SDCS and its supply switched by PIN_SDPWR 
+ */
+#ifndef SD_LOG
+#define SD_LOG      0
+#endif
+
+/** Number of samples buffered in the SRAM log region */
+#define LOG_SAMPLES 512
+
+/** Size of a sample in the SRAM log region */
+#define LOG_SAMPLE  4
+
+/** 
+ * Number of samples added after which the log buffer is written to the 
+ * SD card, ~5 hours at the default display update interval
+ */
+#define LOG_PENDING 96
+
+/** Maximum length of a log record */
+#define LOG_RECORD  32
+
+/** 
+ * Minimum length of a log record, i.e. "0,0.0,0,0.0\n", limiting the 
+ * number of records in a block 
+ */
+#define LOG_RECORD_MIN  12
+
+/**
+ * Appends the given sample to the log buffer in the SRAM log region, 
+ * dropping the oldest buffered sample if the buffer is full. Does nothing 
+ * if there is no log region.
+ * @param sample
+ */
+void logAdd(Sample sample);
+
+/**
+ * Returns true if enough samples were added since the last attempt to
+ * write to the SD card, which is the case every few hours.
+ * @return true if the buffer should be written
+ */
+bool logPending(void);
+
+/**
+ * Initializes the SD card, which must be powered on, and writes the 
+ * buffered samples as lines of comma separated values to the log file,
+ * as many full blocks as they fill. Each block is formatted while it is 
+ * being transmitted, so no block needs to be buffered in RAM. The samples
+ * of the incomplete last block remain in the buffer.
+ * @return true if all full blocks were written, false otherwise
+ */
+bool logFlush(void);
+
+#endif /* LOGGER_H */
@@ -19,44 +19,126 @@
 #include "dejavu.h"
 #include "bitmaps.h"
 #include "display.h"
+#include "history.h"
+#include "minmax.h"
+#include "logger.h"
+#include "config.h"
+#include "timing.h"
+#include "battery.h"
+#include "eink.h"
 #include "utils.h"
 
 static uint32_t avgADCTmp = -1;
 static uint32_t avgADCRh = -1;
 static uint32_t avgMVBat = -1;
 
+/* Short average of the battery voltage measured under load */
+static int16_t mvBatLoad = -1;
+
+/* 
+ * Layout in landscape orientation, 15 rows centered vertically and the 
+ * columns relative to the right edge, i.e. 144, 152, 182 and 216 with the 
+ * 250 pixels wide panel
+ */
+#define ROW_TOP     (((DISPLAY_HEIGHT >> 3) - 15) / 2)
+#define COL_INFO    (DISPLAY_WIDTH - 106)
+#define COL_GRAPH   (DISPLAY_WIDTH - GRAPH_WIDTH - 2)
+#define COL_VOLTS   (DISPLAY_WIDTH - 68)
+#define COL_BITMAP  (DISPLAY_WIDTH - 34)
+/* The note to replace the battery, 15 glyphs of 8 pixels, centered */
+#define COL_NOTE    ((DISPLAY_WIDTH - 15 * 8) / 2)
+
+/* Number of samples in each average while warming up */
+static uint16_t samplesTmp;
+static uint16_t samplesRh;
+static uint16_t samplesBat;
+
+/* Number of samples of the history averaged to a column of a graph */
+#define GRAPH_SAMPLES   3
+
+/* Iterator over the samples of the history for the graph being rescaled */
+static HistoryIterator graphIterator;
+
+/* Samples added since the last column of the graphs and their sums */
+static uint8_t columnSamples = 0;
+static int16_t tmpSum = 0;
+static int16_t rhSum = 0;
+
+/* Minimum and maximum of the averaged ADC values during the last 24 h */
+static MinMax tmpMinMax;
+static MinMax rhMinMax;
+
 static int16_t prevTmpx10;
 static int16_t prevRh;
 static int8_t  prevVBatx10;
 
+static MeterStats stats;
+
+/* Orientation and dark mode the frame was last drawn in */
+static uint8_t prevMode = 0;
+
+/* If the averages were restored and need to be verified */
+static bool restored = false;
+
 /*
  * Converts ratiometric or absolute with the given reference voltage at the 
  * given pin with 16x oversampling during ADC noise reduction mode to reduce 
- * digital noise, updates the given exponential weighted moving average and 
- * returns it.
+ * digital noise and returns the 12-bit value or millivolts.
  */
-static uint32_t convert(uint8_t aref, uint8_t pin, bool ratio, uint32_t avg) {
+static uint32_t sample(uint8_t aref, uint8_t pin, bool ratio) {
     ADMUX = 0x00 | aref | pin;
     set_sleep_mode(SLEEP_MODE_ADC);
 
     uint16_t over = 0;
     for (uint8_t i = 0; i < 17; i++) {
         ADCSRA |= (1 << ADSC);
+#if TIMING
+        // Timer1 is halted in ADC noise reduction mode, so the conversion 
+        // time would not be counted
+        loop_until_bit_is_clear(ADCSRA, ADSC);
+#else
         sleep_mode();
+#endif
         // discard first conversion result after switching reference voltage
         if (i > 0) over += ADC;
     }
 
     uint32_t val = (over >> 2);    
     if (!ratio) {        
-        val = (val * AREF_MV) >> 12;
+        val = (val * config.arefMV) >> 12;
+    }
+    
+    return val;
+}
+
+/*
+ * Samples the given pin, updates the given exponential weighted moving 
+ * average and returns it. Until the given number of samples reaches the 
+ * window of the average, the cumulative average is updated instead so the 
+ * average settles quickly.
+ */
+static uint32_t convert(uint8_t aref, uint8_t pin, bool ratio, uint32_t avg,
+                        uint16_t *samples) {
+    uint32_t val = sample(aref, pin, ratio);
+    
+    if (restored && avg != -1) {
+        // discard a restored average that is no longer plausible
+        uint32_t mean = avg >> config.ewmaBs;
+        if ((val > mean ? val - mean : mean - val) > RESTORE_MAX_DEV) {
+            avg = -1;
+        }
     }
     
     if (avg == -1) {
         // use first measurement as initial value for average
-        return val << EWMA_BS;
+        *samples = 1;
+        return val << config.ewmaBs;
+    } else if (*samples < (1 << config.ewmaBs)) {
+        // warming up, weight each sample with 1/n
+        int32_t diff = (int32_t)(val << config.ewmaBs) - (int32_t)avg;
+        return avg + diff / ++(*samples);
     } else {
-        return val + avg - (avg >> EWMA_BS);
+        return val + avg - (avg >> config.ewmaBs);
     }
 }
 
@@ -77,6 +159,36 @@ static char * formatTmp(int16_t tmpx10) {
     return buf;
 }
 
+/**
+ * Formats the given minimum and maximum temperature multiplied by 10 
+ * and returns them.
+ * @param minx10
+ * @param maxx10
+ * @return string
+ */
+static char * formatTmpMinMax(int16_t minx10, int16_t maxx10) {
+    div_t min = div(minx10, 10);
+    div_t max = div(maxx10, 10);
+    static char buf[24];
+    snprintf(buf, sizeof (buf), "↓%d.%d ↑%d.%d", 
+            min.quot, abs(min.rem), max.quot, abs(max.rem));
+    
+    return buf;
+}
+
+/**
+ * Formats the given minimum and maximum relative humidity and returns them.
+ * @param min
+ * @param max
+ * @return string
+ */
+static char * formatRhMinMax(int16_t min, int16_t max) {
+    static char buf[20];
+    snprintf(buf, sizeof (buf), "↓%d%% ↑%d%%", min, max);
+    
+    return buf;
+}
+
 /**
  * Formats the given relative humidity value and returns it.
  * @param rh
@@ -94,22 +206,34 @@ static char * formatRh(int16_t rh) {
 }
 
 /**
- * Returns the bitmap index for the given battery voltage in V multiplied by 10.
- * @param vBatx10
+ * Returns the bitmap index for the given state of charge in %.
+ * @param soc
  * @return index
  */
-static uint8_t bitmapBat(int8_t vBatx10) {    
-    if (vBatx10 < 31) return BAT_0PCT;
-    if (vBatx10 < 33) return BAT_13PCT;
-    if (vBatx10 < 35) return BAT_25PCT;
-    if (vBatx10 < 37) return BAT_38PCT;
-    if (vBatx10 < 39) return BAT_50PCT;
-    if (vBatx10 < 41) return BAT_63PCT;
-    if (vBatx10 < 43) return BAT_75PCT;
-    if (vBatx10 < 45) return BAT_88PCT;
+static uint8_t bitmapBat(uint8_t soc) {    
+    if (soc < 7) return BAT_0PCT;
+    if (soc < 19) return BAT_13PCT;
+    if (soc < 32) return BAT_25PCT;
+    if (soc < 44) return BAT_38PCT;
+    if (soc < 57) return BAT_50PCT;
+    if (soc < 69) return BAT_63PCT;
+    if (soc < 82) return BAT_75PCT;
+    if (soc < 94) return BAT_88PCT;
     return BAT_100PCT;
 }
 
+/**
+ * Formats the given estimated number of days remaining and returns it.
+ * @param days
+ * @return string
+ */
+static char * formatDays(int16_t days) {
+    static char buf[6];
+    snprintf(buf, sizeof (buf), "%dd", days > 999 ? 999 : days);
+    
+    return buf;
+}
+
 /**
  * Formats the given battery voltage in V multiplied by 10 and returns it.
  * @param vBatx10
@@ -123,36 +247,329 @@ static char * formatBat(int16_t vBatx10) {
     return buf;
 }
 
+/**
+ * Calculates the temperature in °C multiplied by 10 from the given 
+ * averaged ADC value and returns it.
+ * @param adc
+ * @return temperature x10
+ */
+static int16_t calcTmpx10(uint16_t adc) {
+    // resistance of the thermistor
+    float resTh = (4096.0 / fmax(1, adc) - 1) * TH_SERI;
+    // temperature in °C
+    float tmp = 1.0 / (1.0 / TH_BETA * log(resTh / TH_RESI) + 1.0 / TH_TEMP) - TMP_0C;
+    
+    // somehow I don't like to work with floats
+    return tmp * 10;
+}
+
+/**
+ * Calculates the relative humidity in % from the given averaged ADC value, 
+ * compensated for the given temperature multiplied by 10, and returns it.
+ * @param adc
+ * @param tmpx10
+ * @return relative humidity
+ */
+static int16_t calcRh(uint16_t adc, int16_t tmpx10) {
+    // relative humidity in %
+    int32_t rh = (((int32_t)adc - config.rhADC0) * (int32_t)derived.rhPerADC + 0x80000) >> 20;
+    // temperature compensation of relative humidity
+    return divRoundNearest(rh * 1000000, 1054600 - tmpx10 * 216UL);
+}
+
+/**
+ * Starts iterating over the most recent samples of the history that make 
+ * up the columns of a graph and returns the number of columns, leaving 
+ * out the samples added since the last column.
+ * @return number of columns
+ */
+static uint8_t rewindGraph(void) {
+    uint16_t length = historyLength();
+    uint16_t columns = length > columnSamples ? 
+            (length - columnSamples) / GRAPH_SAMPLES : 0;
+    if (columns > GRAPH_WIDTH) {
+        columns = GRAPH_WIDTH;
+    }
+    historyIterateLast(&graphIterator, columns * GRAPH_SAMPLES + columnSamples);
+    
+    return columns;
+}
+
+/**
+ * Returns the average temperature or relative humidity of the samples of 
+ * the next column of a graph.
+ * @param rh
+ * @return average
+ */
+static int16_t nextColumn(bool rh) {
+    int16_t sum = 0;
+    for (uint8_t i = 0; i < GRAPH_SAMPLES; i++) {
+        Sample sample;
+        historyNext(&graphIterator, &sample);
+        sum += rh ? sample.rh : sample.tmpx10;
+    }
+    
+    return sum / GRAPH_SAMPLES;
+}
+
+/**
+ * Returns the average temperature of the next column of the graph.
+ * @return temperature x10
+ */
+static int16_t nextTmpColumn(void) {
+    return nextColumn(false);
+}
+
+/**
+ * Returns the average relative humidity of the next column of the graph.
+ * @return relative humidity
+ */
+static int16_t nextRhColumn(void) {
+    return nextColumn(true);
+}
+
+/* Graphs of the recent temperature and relative humidity */
+static Graph tmpGraph = {.rewind = rewindGraph, .next = nextTmpColumn};
+static Graph rhGraph = {.rewind = rewindGraph, .next = nextRhColumn};
+
+/**
+ * Draws the most recently calculated temperature, relative humidity and 
+ * battery voltage values to the frame in portrait orientation, stacked and
+ * without graphs.
+ */
+static void drawValuesPortrait(void) {
+    const __flash Font *unifont = &unifontFont;
+    const __flash Font *dejavu = &dejaVuFont;
+    
+    // clear frame
+    setFrame(0x00);
+    // battery voltage, estimated days remaining and bitmap
+    writeString(0, 0, unifont, formatBat(prevVBatx10));
+    int16_t days = estimateDays();
+    if (days >= 0) {
+        writeString(0, 40, unifont, formatDays(days));
+    }
+    writeBitmap(0, (DISPLAY_HEIGHT - 32) & ~0x07, bitmapBat(calcSoc()));
+    // temperature with min/max and label
+    writeString(2, 0, dejavu, formatTmp(prevTmpx10));
+    if (minMaxValid(&tmpMinMax)) {
+        writeString(9, 0, unifont, formatTmpMinMax(
+                calcTmpx10(tmpMinMax.min), calcTmpx10(tmpMinMax.max)));
+    }
+    writeString(11, 0, unifont, "Temperature");
+    // humidity with min/max and label
+    writeString(14, 0, dejavu, formatRh(prevRh));
+    if (minMaxValid(&rhMinMax)) {
+        writeString(21, 0, unifont, formatRhMinMax(
+                calcRh(rhMinMax.min, prevTmpx10), 
+                calcRh(rhMinMax.max, prevTmpx10)));
+    }
+    writeString(23, 0, unifont, "Humidity");
+}
+
+/**
+ * Draws the most recently calculated temperature, relative humidity and 
+ * battery voltage values to the frame in the configured orientation.
+ */
+static void drawValues(void) {
+    const __flash Font *unifont = &unifontFont;
+    const __flash Font *dejavu = &dejaVuFont;
+    
+    if (config.orient == ORIENT_PORTRAIT) {
+        drawValuesPortrait();
+        return;
+    }
+    
+    // clear frame
+    setFrame(0x00);
+    // battery voltage, bitmap and estimated days remaining
+    writeString(ROW_TOP, COL_VOLTS, unifont, formatBat(prevVBatx10));
+    writeBitmap(ROW_TOP, COL_BITMAP, bitmapBat(calcSoc()));
+    int16_t days = estimateDays();
+    if (days >= 0) {
+        writeString(ROW_TOP, COL_INFO, unifont, formatDays(days));
+    }
+    // temperature with graph, min/max and label
+    writeString(ROW_TOP + 1, 0, dejavu, formatTmp(prevTmpx10));
+    writeGraph(ROW_TOP + 2, COL_GRAPH, 2, &tmpGraph);
+    if (minMaxValid(&tmpMinMax)) {
+        // the ADC value increases with the temperature
+        writeString(ROW_TOP + 4, COL_INFO, unifont, formatTmpMinMax(
+                calcTmpx10(tmpMinMax.min), calcTmpx10(tmpMinMax.max)));
+    }
+    writeString(ROW_TOP + 6, COL_INFO, unifont, "Temperature");
+    // humidity with graph, min/max and label
+    writeString(ROW_TOP + 8, 0, dejavu, formatRh(prevRh));
+    writeGraph(ROW_TOP + 9, COL_GRAPH, 2, &rhGraph);
+    if (minMaxValid(&rhMinMax)) {
+        // compensated with the current temperature, close enough
+        writeString(ROW_TOP + 11, COL_INFO, unifont, formatRhMinMax(
+                calcRh(rhMinMax.min, prevTmpx10), 
+                calcRh(rhMinMax.max, prevTmpx10)));
+    }
+    writeString(ROW_TOP + 13, COL_INFO, unifont, "Humidity");
+}
+
+/**
+ * Draws a note that the batteries need to be replaced with the last 
+ * displayed values to the frame.
+ */
+static void drawBatteryLow(void) {
+    const __flash Font *unifont = &unifontFont;
+    div_t tmp = div(prevTmpx10, 10);
+    div_t bat = div(prevVBatx10, 10);
+    char buf[40];
+    snprintf(buf, sizeof (buf), "Last values: %s%d.%d° %d%% %d.%dV",
+            prevTmpx10 < 0 ? "-" : "", abs(tmp.quot), abs(tmp.rem), 
+            prevRh, bat.quot, bat.rem);
+    
+    setFrame(0x00);
+    writeBitmap(ROW_TOP, COL_BITMAP, BAT_0PCT);
+    writeString(ROW_TOP + 6, COL_NOTE, unifont, "Replace battery");
+    writeString(ROW_TOP + 13, 0, unifont, buf);
+}
+
+/**
+ * Sets the configured orientation and dark mode of the display and returns 
+ * true if either changed since the frame was last drawn.
+ * @return true if changed
+ */
+static bool setDisplayMode(void) {
+    setOrientation(config.orient);
+    setDarkMode(config.darkMode);
+    uint8_t mode = (config.orient << 1) | config.darkMode;
+    bool changed = mode != prevMode;
+    prevMode = mode;
+    
+    return changed;
+}
+
 int16_t getMVBat(void) {
-    return (avgMVBat >> EWMA_BS);
+    return (avgMVBat >> config.ewmaBs);
+}
+
+int16_t getMVBatLoad(void) {
+    if (mvBatLoad == -1) {
+        return getMVBat();
+    }
+    
+    return mvBatLoad;
+}
+
+void resetAverages(void) {
+    avgADCTmp = -1;
+    avgADCRh = -1;
+    avgMVBat = -1;
+}
+
+void getMeterState(MeterState *state) {
+    *state = (MeterState) {
+        avgADCTmp, avgADCRh, avgMVBat, prevTmpx10, prevRh, prevVBatx10
+    };
+}
+
+void setMeterState(const MeterState *state) {
+    avgADCTmp = state->avgADCTmp;
+    avgADCRh = state->avgADCRh;
+    avgMVBat = state->avgMVBat;
+    prevTmpx10 = state->prevTmpx10;
+    prevRh = state->prevRh;
+    prevVBatx10 = state->prevVBatx10;
+    samplesTmp = samplesRh = samplesBat = 1 << config.ewmaBs;
+    restored = true;
+}
+
+void elapseMinMax(uint16_t secs) {
+    minMaxElapse(&tmpMinMax, secs);
+    minMaxElapse(&rhMinMax, secs);
+}
+
+bool isWarmingUp(void) {
+    uint16_t window = 1 << config.ewmaBs;
+    
+    return samplesTmp < window || samplesRh < window || samplesBat < window;
+}
+
+const MeterStats * getMeterStats(void) {
+    return &stats;
 }
 
 void measureValues(void) {
-    avgADCTmp = convert(AREF_AVCC, PIN_TMP, true, avgADCTmp);
-    avgADCRh = convert(AREF_AVCC, PIN_RH, true, avgADCRh);
+    stats.measurements++;
+    accountCharge(CHARGE_MEASURE);
+    avgADCTmp = convert(AREF_AVCC, PIN_TMP, true, avgADCTmp, &samplesTmp);
+    avgADCRh = convert(AREF_AVCC, PIN_RH, true, avgADCRh, &samplesRh);
     // give the capacitor between AREF and GND some time to discharge
     _delay_us(150);
-    avgMVBat = convert(AREF_INT, PIN_BAT, false, avgMVBat);
+    avgMVBat = convert(AREF_INT, PIN_BAT, false, avgMVBat, &samplesBat);
+    restored = false;
+    checkBattery();
+    // track min/max of the raw averages to keep floats out of this phase
+    minMaxAdd(&tmpMinMax, avgADCTmp >> config.ewmaBs);
+    minMaxAdd(&rhMinMax, avgADCRh >> config.ewmaBs);
 }
 
-bool displayValues(bool fast) {    
-    // resistance of the thermistor
-    float resTh = (4096.0 / fmax(1, (avgADCTmp >> EWMA_BS)) - 1) * TH_SERI;
-    // temperature in °C
-    float tmp = 1.0 / (1.0 / TH_BETA * log(resTh / TH_RESI) + 1.0 / TH_TEMP) - TMP_0C;
-    // somehow I don't like to work with floats
-    int16_t tmpx10 = tmp * 10;
-    
-    // relative humidity in %
-    int32_t rh = divRoundNearest(((avgADCRh >> EWMA_BS) - RH_ADC_0) * 100, RH_ADC);    
-    // temperature compensation of relative humidity
-    rh = divRoundNearest(rh * 1000000, 1054600 - tmpx10 * 216UL);
+void measureBatLoad(void) {
+    int16_t mv = sample(AREF_INT, PIN_BAT, false);
+    // only one sample per update, so weight it with 1/2 for the cutoff to 
+    // react within one or two updates
+    mvBatLoad = mvBatLoad == -1 ? mv : (mvBatLoad + mv + 1) >> 1;
+}
+
+Sample calcValues(void) {
+    int16_t tmpx10 = calcTmpx10(avgADCTmp >> config.ewmaBs);
+    int16_t rh = calcRh(avgADCRh >> config.ewmaBs, tmpx10);
     
     // battery voltage in V x10 (measured one fifth by voltage divider)
-    int8_t vBatx10 = divRoundNearest((avgMVBat >> EWMA_BS), 20);
+    int8_t vBatx10 = divRoundNearest((avgMVBat >> config.ewmaBs), 20);
+    
+    return (Sample) {tmpx10, rh, vBatx10};
+}
+
+void recordValues(void) {
+    Sample values = calcValues();
+    historyAdd(values);
+    
+    // shift a new column into the graphs every GRAPH_SAMPLES samples
+    tmpSum += values.tmpx10;
+    rhSum += values.rh;
+    if (++columnSamples == GRAPH_SAMPLES) {
+        columnSamples = 0;
+        graphAdd(&tmpGraph, tmpSum / GRAPH_SAMPLES);
+        graphAdd(&rhGraph, rhSum / GRAPH_SAMPLES);
+        tmpSum = 0;
+        rhSum = 0;
+    }
+#if SD_LOG
+    logAdd(values);
+#endif
+}
+
+void displayBatteryLow(void) {
+    setDisplayMode();
+    // the note is laid out in landscape orientation
+    setOrientation(ORIENT_LANDSCAPE);
+#if RENDER_BANDED
+    doDisplayBanded(drawBatteryLow, false);
+#else
+    drawBatteryLow();
+    doDisplay(false);
+#endif
+}
+
+bool displayValues(bool fast) {    
+    Sample values = calcValues();
+    int16_t tmpx10 = values.tmpx10;
+    int16_t rh = values.rh;
+    int8_t vBatx10 = values.vBatx10;
     
-    if (tmpx10 == prevTmpx10 && rh == prevRh && vBatx10 == prevVBatx10) {
-        // skip update of display if no change in measurements
+    if (setDisplayMode()) {
+        // redraw completely in the new mode
+        fast = false;
+    } else if (abs(tmpx10 - prevTmpx10) < config.hystTmpx10 && 
+            abs(rh - prevRh) < config.hystRh && vBatx10 == prevVBatx10) {
+        // skip update of display if no significant change in measurements
+        stats.skippedUpdates++;
         return false;
     }
     
@@ -160,22 +577,23 @@ bool displayValues(bool fast) {
     prevRh = rh;
     prevVBatx10 = vBatx10;
     
-    const __flash Font *unifont = &unifontFont;
-    const __flash Font *dejavu = &dejaVuFont;
-    
-    // clear frame
-    setFrame(0x00);
-    // battery voltage and bitmap
-    writeString(0, 182, unifont, formatBat(vBatx10));
-    writeBitmap(0, 216, bitmapBat(vBatx10));
-    // temperature with label
-    writeString(1, 0, dejavu, formatTmp(tmpx10));
-    writeString(5, 144, unifont, "Temperature");
-    // humidity with label
-    writeString(8, 0, dejavu, formatRh(rh));
-    writeString(12, 144, unifont, "Humidity");
+#if RENDER_BANDED
+    doDisplayBanded(drawValues, fast);
+#else
+    PHASE_BEGIN();
+    drawValues();
+    PHASE_END(PHASE_RENDER);
     // update display
     doDisplay(fast);
+#endif
+    accountCharge(CHARGE_RENDER);
+    if (fast) {
+        stats.fastUpdates++;
+        accountCharge(CHARGE_FAST);
+    } else {
+        stats.fullUpdates++;
+        accountCharge(CHARGE_FULL);
+    }
     
     return true;
 }
@@ -8,12 +8,16 @@
 #ifndef METER_H
 #define METER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "history.h"
+
 /** Use AVCC as reference voltage */
 #define AREF_AVCC   (1 << REFS0)
 /** Use internal 1.1V reference voltage */
 #define AREF_INT    (1 << REFS1) | (1 << REFS0)
 
-#define AREF_MV     1100 // 1136
+#define AREF_MV     1100 // 1136, default, see Config
 
 /** 0°C in Kelvin */
 #define TMP_0C      273.15
@@ -25,26 +29,146 @@
 /** Serial resistance */
 #define TH_SERI     100000
 
-/** Ratiometric response of the HIH-5030 at 0%RH and 100%RH with 12-bit ADC */
+/**
+ * Ratiometric response of the HIH-5030 at 0%RH and 100%RH with 12-bit ADC,
+ * defaults, see Config
+ */
 #define RH_ADC_0    620  // Vout = Vsupply * 0.1515
 #define RH_ADC_100  3225 // Vout = Vsupply * 0.7875
-#define RH_ADC      RH_ADC_100 - RH_ADC_0
 
-/** Battery cutoff voltage in millivolts */
+/**
+ * Minimum difference of the ADC values at 0%RH and 100%RH, so the humidity
+ * in %RH << 20 per ADC step times the 12-bit ADC value fits in 32 bits
+ */
+#define RH_ADC_SPAN 256
+
+/** Default battery cutoff voltage in millivolts */
 #define BAT_LOW     3000
 
-/** Weight of the exponential weighted moving average as bit shift */
+/** Measure the battery voltage also under load while updating the display */
+#ifndef BAT_LOAD
+#define BAT_LOAD    1
+#endif
+
+/** Time in ms to let the load and reference settle before measuring */
+#define BAT_LOAD_DELAY  50
+
+/** 
+ * Minimum width of the frame in pixels to lay out the values in portrait 
+ * orientation, the width of the widest temperature "-99.9°" in DejaVu
+ */
+#define PORTRAIT_MIN_WIDTH  152
+
+/** Default weight of the exponential weighted moving average as bit shift */
 #define EWMA_BS     4
 
+/** 
+ * Maximum deviation of a measurement from a restored average for it to 
+ * be still plausible, ~1.4°C, ~2.5%RH, ~0.3V battery voltage 
+ */
+#define RESTORE_MAX_DEV 64
+
+/**
+ * Counters of measurements and display updates.
+ */
+typedef struct {
+    /** Number of measurements. */
+    uint32_t measurements;
+    /** Number of full display updates. */
+    uint16_t fullUpdates;
+    /** Number of fast display updates. */
+    uint16_t fastUpdates;
+    /** Number of display updates skipped for no significant change. */
+    uint16_t skippedUpdates;
+} MeterStats;
+
+/**
+ * Averages and last displayed values to be restored after a reset.
+ */
+typedef struct {
+    uint32_t avgADCTmp;
+    uint32_t avgADCRh;
+    uint32_t avgMVBat;
+    int16_t prevTmpx10;
+    int16_t prevRh;
+    int8_t prevVBatx10;
+} MeterState;
+
 /** Returns the battery voltage in millivolts divided by 5 */
 int16_t getMVBat(void);
 
+/** 
+ * Returns the battery voltage in millivolts divided by 5 measured under 
+ * load, averaged with a weight of 1/2 per update, or at rest if it was not yet 
+ * measured under load
+ */
+int16_t getMVBatLoad(void);
+
+/**
+ * Discards the averaged values so that the next measurement is used as 
+ * initial value, i.e. after the weight of the average was changed.
+ */
+void resetAverages(void);
+
+/**
+ * Copies the averages and last displayed values to the given state.
+ * @param state
+ */
+void getMeterState(MeterState *state);
+
+/**
+ * Restores the averages and last displayed values from the given state. 
+ * Each average is discarded with the next measurement if that deviates 
+ * more than RESTORE_MAX_DEV from it.
+ * @param state
+ */
+void setMeterState(const MeterState *state);
+
+/**
+ * Advances the window of the minimum and maximum values by the given 
+ * number of seconds.
+ * @param secs
+ */
+void elapseMinMax(uint16_t secs);
+
+/**
+ * Returns true while the averages have fewer samples than their window,
+ * so measuring more frequently lets them settle sooner.
+ * @return true while warming up
+ */
+bool isWarmingUp(void);
+
+/**
+ * Returns the counters of measurements and display updates.
+ * @return stats
+ */
+const MeterStats * getMeterStats(void);
+
+/**
+ * Calculates temperature, relative humidity and battery voltage from the 
+ * averaged measurements and returns them.
+ * @return values
+ */
+Sample calcValues(void);
+
 /**
  * Measures temperature, relative humidity and battery voltage and updates 
  * the average values.
  */
 void measureValues(void);
 
+/**
+ * Measures the battery voltage under load and updates its short average, 
+ * to be called while the display is busy updating, with the ADC enabled.
+ */
+void measureBatLoad(void);
+
+/**
+ * Calculates the averaged temperature, relative humidity and battery voltage
+ * values and adds them to the history, the graphs and the SD card log.
+ */
+void recordValues(void);
+
 /**
  * Calculates, formats and displays the averaged temperature, relative humidity 
  * and battery voltage values. Updates the display either in fast or full update
@@ -53,5 +177,11 @@ void measureValues(void);
  */
 bool displayValues(bool fast);
 
+/**
+ * Displays a note that the batteries need to be replaced with the last
+ * displayed values, with a full update.
+ */
+void displayBatteryLow(void);
+
 #endif /* METER_H */
 
@@ -0,0 +1,77 @@
+/* 
+ * File:   minmax.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:53
+ */
+
+#include "minmax.h"
+
+/**
+ * Recalculates the minimum and maximum of the window from the buckets 
+ * in use.
+ * @param minMax
+ */
+static void recalc(MinMax *minMax) {
+    minMax->min = UINT16_MAX;
+    minMax->max = 0;
+    for (uint8_t i = 0; i < minMax->buckets; i++) {
+        if (minMax->mins[i] < minMax->min) minMax->min = minMax->mins[i];
+        if (minMax->maxs[i] > minMax->max) minMax->max = minMax->maxs[i];
+    }
+}
+
+/**
+ * Starts a new empty bucket, replacing the oldest one if all are in use.
+ * @param minMax
+ */
+static void startBucket(MinMax *minMax) {
+    if (minMax->buckets > 0) {
+        minMax->bucket = (minMax->bucket + 1) % MINMAX_BUCKETS;
+    }
+    if (minMax->buckets < MINMAX_BUCKETS) {
+        minMax->buckets++;
+    }
+    minMax->mins[minMax->bucket] = UINT16_MAX;
+    minMax->maxs[minMax->bucket] = 0;
+}
+
+void minMaxAdd(MinMax *minMax, uint16_t value) {
+    if (minMax->buckets == 0) {
+        startBucket(minMax);
+        recalc(minMax);
+    }
+
+    if (value < minMax->mins[minMax->bucket]) {
+        minMax->mins[minMax->bucket] = value;
+        if (value < minMax->min) minMax->min = value;
+    }
+    if (value > minMax->maxs[minMax->bucket]) {
+        minMax->maxs[minMax->bucket] = value;
+        if (value > minMax->max) minMax->max = value;
+    }
+}
+
+void minMaxElapse(MinMax *minMax, uint16_t secs) {
+    if (minMax->buckets == 0) {
+        return;
+    }
+
+    uint32_t elapsed = (uint32_t)minMax->secs + secs;
+    if (elapsed < MINMAX_BUCKET_SECS) {
+        minMax->secs = elapsed;
+        return;
+    }
+
+    while (elapsed >= MINMAX_BUCKET_SECS) {
+        elapsed -= MINMAX_BUCKET_SECS;
+        startBucket(minMax);
+    }
+    minMax->secs = elapsed;
+    recalc(minMax);
+}
+
+bool minMaxValid(const MinMax *minMax) {
+    // empty buckets have a minimum above their maximum
+    return minMax->buckets > 0 && minMax->min <= minMax->max;
+}
@@ -0,0 +1,67 @@
+/* 
+ * File:   minmax.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:53
+ */
+
+#ifndef MINMAX_H
+#define MINMAX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Number of buckets in the sliding window */
+#define MINMAX_BUCKETS      24
+/** Number of seconds per bucket, 1 h */
+#define MINMAX_BUCKET_SECS  3600
+
+/**
+ * Minimum and maximum of the values added during a sliding window of
+ * MINMAX_BUCKETS buckets of MINMAX_BUCKET_SECS seconds each, regardless
+ * of how often values are added.
+ */
+typedef struct {
+    /** Minimum of the values in each bucket. */
+    uint16_t mins[MINMAX_BUCKETS];
+    /** Maximum of the values in each bucket. */
+    uint16_t maxs[MINMAX_BUCKETS];
+    /** Index of the current bucket. */
+    uint8_t bucket;
+    /** Number of buckets in use. */
+    uint8_t buckets;
+    /** Number of seconds elapsed in the current bucket. */
+    uint16_t secs;
+    /** Minimum of the values in the window. */
+    uint16_t min;
+    /** Maximum of the values in the window. */
+    uint16_t max;
+} MinMax;
+
+/**
+ * Adds the given value to the current bucket of the given min/max, 
+ * updating the minimum and maximum of the window in constant time.
+ * @param minMax
+ * @param value
+ */
+void minMaxAdd(MinMax *minMax, uint16_t value);
+
+/**
+ * Advances the window of the given min/max by the given number of seconds. 
+ * Each time the current bucket is MINMAX_BUCKET_SECS old, an empty one is 
+ * started, the oldest one is dropped if all are in use, and the minimum 
+ * and maximum of the window are recalculated from the buckets. Time before 
+ * the first value was added does not count.
+ * @param minMax
+ * @param secs
+ */
+void minMaxElapse(MinMax *minMax, uint16_t secs);
+
+/**
+ * Returns true if a value was added to the given min/max within the window.
+ * @param minMax
+ * @return true if min and max are valid
+ */
+bool minMaxValid(const MinMax *minMax);
+
+#endif /* MINMAX_H */
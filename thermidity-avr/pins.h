@@ -43,4 +43,20 @@
 #define PIN_RST   PD6 // display reset
 #define PIN_BUSY  PD5 // display busy
 
+/* SD card */
+#define DDR_SD    DDRD
+#define PORT_SD   PORTD
+#define PIN_SDCS  PD2 // SD card chip select
+#define PIN_SDPWR PD3 // SD card power switch
+
+/* USART */
+#define PINP_USART PIND
+#define PIN_RXD    PD0
+
+/* Display on USART0 in Master SPI Mode (DISPLAY_MSPIM) */
+#define DDR_MSPIM  DDRD
+#define PORT_MSPIM PORTD
+#define PIN_XCK    PD4 // display SCK
+#define PIN_TXD    PD1 // display MOSI
+
 #endif /* PINS_H */
@@ -0,0 +1,105 @@
+/*
+ * File:   power.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:15
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "power.h"
+#include "pins.h"
+#include "utils.h"
+
+/**
+ * Clock of a module or supply pins of a user and the sleep mode it allows.
+ */
+typedef struct {
+    /** Bit in the power reduction register or 0. */
+    uint8_t prr;
+    /** Port and pins driven high while in use, low otherwise, or NULL. */
+    volatile uint8_t *port;
+    uint8_t pins;
+    /** Depth of the deepest sleep mode allowed while in use. */
+    uint8_t depth;
+} PowerUser;
+
+/* Sleep modes by depth */
+#define DEPTH_IDLE      0
+#define DEPTH_ADC       1
+#define DEPTH_PWR_DOWN  2
+
+static const __flash uint8_t modes[] = {
+    SLEEP_MODE_IDLE, SLEEP_MODE_ADC, SLEEP_MODE_PWR_DOWN
+};
+
+static const __flash PowerUser powerUsers[] = {
+    [POWER_ADC]     = {(1 << PRADC),    NULL, 0, DEPTH_ADC},
+    [POWER_SPI]     = {(1 << PRSPI),    NULL, 0, DEPTH_IDLE},
+    [POWER_USART]   = {(1 << PRUSART0), NULL, 0, DEPTH_IDLE},
+    [POWER_TIMER1]  = {(1 << PRTIM1),   NULL, 0, DEPTH_IDLE},
+    [POWER_SENSORS] = {0, &PORT_SENS, (1 << PIN_PWR), DEPTH_PWR_DOWN},
+    // drive CS high as well so the card is not selected when powered on
+    [POWER_SD]      = {0, &PORT_SD, (1 << PIN_SDPWR) | (1 << PIN_SDCS),
+                        DEPTH_PWR_DOWN}
+};
+
+/* Reference count of each user */
+static volatile uint8_t counts[POWER_USERS];
+
+void initPower(void) {
+    // stop TWI, all timers, SPI, USART and ADC
+    PRR = (1 << PRTWI) | (1 << PRTIM0) | (1 << PRTIM1) | (1 << PRTIM2) |
+          (1 << PRSPI) | (1 << PRUSART0) | (1 << PRADC);
+    // the analog comparator is not used but enabled by default
+    ACSR |= (1 << ACD);
+}
+
+void powerOn(uint8_t user) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (counts[user]++ > 0) {
+            return;
+        }
+
+        const __flash PowerUser *power = &powerUsers[user];
+        PRR &= ~power->prr;
+        if (power->port != NULL) {
+            *power->port |= power->pins;
+        }
+    }
+}
+
+void powerOff(uint8_t user) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (counts[user] == 0 || --counts[user] > 0) {
+            return;
+        }
+
+        const __flash PowerUser *power = &powerUsers[user];
+        if (power->port != NULL) {
+            *power->port &= ~power->pins;
+        }
+        PRR |= power->prr;
+    }
+}
+
+void powerSleep(void) {
+    uint8_t depth = DEPTH_PWR_DOWN;
+    for (uint8_t i = 0; i < POWER_USERS; i++) {
+        if (counts[i] > 0 && powerUsers[i].depth < depth) {
+            depth = powerUsers[i].depth;
+        }
+    }
+
+    set_sleep_mode(modes[depth]);
+    sleep_enable();
+    if (depth == DEPTH_PWR_DOWN) {
+        // BOD disable is only effective for the next sleep
+        sleep_bod_disable();
+    }
+    sei();
+    sleep_cpu();
+    sleep_disable();
+}
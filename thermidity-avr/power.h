@@ -0,0 +1,52 @@
+/*
+ * File:   power.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:15
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+/** Users of a module or supply, each with its own reference count */
+#define POWER_ADC       0 // ADC, allows ADC noise reduction sleep mode
+#define POWER_SPI       1 // SPI, allows idle sleep mode
+#define POWER_USART     2 // USART, also in Master SPI Mode, allows idle
+#define POWER_TIMER1    3 // Timer1, allows idle sleep mode
+#define POWER_SENSORS   4 // supply of the sensors
+#define POWER_SD        5 // supply of the SD card
+#define POWER_USERS     6
+
+/**
+ * Stops the clock of all modules and disables the analog comparator.
+ * The modules keep their configuration while their clock is stopped,
+ * so to be called after setting them up.
+ */
+void initPower(void);
+
+/**
+ * Adds a user of the given module or supply, starting its clock or
+ * switching its supply on with the first user.
+ * @param user one of POWER_*
+ */
+void powerOn(uint8_t user);
+
+/**
+ * Removes a user of the given module or supply, stopping its clock or
+ * switching its supply off with the last user. A module must be disabled
+ * before its last user is removed.
+ * @param user one of POWER_*
+ */
+void powerOff(uint8_t user);
+
+/**
+ * Sleeps in the deepest sleep mode that the modules in use allow, in
+ * power-down sleep mode with BOD disabled if no clock is needed. To be
+ * called with interrupts disabled, returns with interrupts enabled after
+ * waking up.
+ */
+void powerSleep(void);
+
+#endif /* POWER_H */
@@ -0,0 +1,83 @@
+/*
+ * File:   sched.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:18
+ */
+
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <util/atomic.h>
+#include "sched.h"
+
+/* Scheduler time in seconds, wraps around after ~18 hours */
+static volatile uint16_t now = 0;
+
+/* If the watchdog barked since the tasks were last run */
+static volatile bool pending = true;
+
+/* Scheduler time when the elapsed seconds were last returned */
+static uint16_t then = 0;
+
+ISR(WDT_vect) {
+    now += SCHED_PERIOD;
+    pending = true;
+}
+
+/**
+ * Returns the scheduler time in seconds.
+ * @return time
+ */
+static uint16_t getNow(void) {
+    uint16_t time;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        time = now;
+    }
+
+    return time;
+}
+
+void initScheduler(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        wdt_reset();
+        // watchdog change enable
+        WDTCSR |= (1 << WDCE) | (1 << WDE);
+        // enable interrupt, disable system reset, 8 seconds
+        WDTCSR = (1 << WDIE) | (0 << WDE) | (1 << WDP3) | (1 << WDP0);
+    }
+}
+
+bool schedPending(void) {
+    return pending;
+}
+
+uint16_t schedElapsed(void) {
+    uint16_t time = getNow();
+    uint16_t elapsed = time - then;
+    then = time;
+
+    return elapsed;
+}
+
+void runTasks(Task *tasks, uint8_t count) {
+    pending = false;
+    uint16_t time = getNow();
+
+    while (true) {
+        Task *next = NULL;
+        for (uint8_t i = 0; i < count; i++) {
+            Task *task = &tasks[i];
+            if ((int16_t)(task->due - time) <= 0 &&
+                    (next == NULL || task->priority < next->priority)) {
+                next = task;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        next->run();
+        next->due = time + next->period();
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * File:   sched.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:18
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Period of the watchdog in seconds */
+#define SCHED_PERIOD    8
+
+/**
+ * A task run periodically by the scheduler.
+ */
+typedef struct {
+    /** Tasks due at the same time are run by ascending priority. */
+    uint8_t priority;
+    /** Returns the time in seconds until the task is due again. */
+    uint16_t (*period)(void);
+    /** Runs the task. */
+    void (*run)(void);
+    /** Scheduler time in seconds the task is due next. */
+    uint16_t due;
+} Task;
+
+/**
+ * Sets up the watchdog to wake up every SCHED_PERIOD seconds.
+ */
+void initScheduler(void);
+
+/**
+ * Returns true if the watchdog woke up the MCU since the tasks were last
+ * run.
+ * @return true if the tasks are to be run
+ */
+bool schedPending(void);
+
+/**
+ * Returns the number of seconds elapsed since the last call.
+ * @return elapsed seconds
+ */
+uint16_t schedElapsed(void);
+
+/**
+ * Runs the given tasks that are due by priority. Task periods should be
+ * multiples of SCHED_PERIOD, as tasks are only run when the watchdog barks.
+ * @param tasks
+ * @param count
+ */
+void runTasks(Task *tasks, uint8_t count);
+
+#endif /* SCHED_H */
@@ -0,0 +1,226 @@
+/* 
+ * File:   sdcard.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:58
+ */
+
+#include <stddef.h>
+#include <util/delay.h>
+#include "sdcard.h"
+#include "spi.h"
+
+/* Attempts to wait for a response, a data token or the card not busy */
+#define SD_RETRIES  0xffff
+
+/* Card is SDHC/SDXC addressed by block rather than SDSC by byte */
+static bool blockAddressing = false;
+
+/* Number of bytes of the block being read or written transferred so far */
+static uint16_t position = 0;
+
+/**
+ * Receives the given number of bytes into the given buffer, keeping DI 
+ * high as required by the card.
+ * @param data
+ * @param length
+ */
+static void receive(uint8_t *data, uint16_t length) {
+    while (length-- > 0) {
+        *data++ = transmit(0xff);
+    }
+}
+
+/**
+ * Sends the given command with the given argument and returns the R1
+ * response, 0xff if there was none. Only CMD0 and CMD8 need a valid CRC.
+ * @param cmd
+ * @param arg
+ * @return R1 response
+ */
+static uint8_t command(uint8_t cmd, uint32_t arg) {
+    transmit(0xff);
+    transmit(0x40 | cmd);
+    transmit(arg >> 24);
+    transmit(arg >> 16);
+    transmit(arg >> 8);
+    transmit(arg);
+    transmit(cmd == SD_GO_IDLE_STATE ? 0x95 : cmd == SD_SEND_IF_COND ? 0x87 : 0x01);
+    
+    uint8_t r1 = 0xff;
+    for (uint8_t i = 0; i < 10 && (r1 & 0x80); i++) {
+        r1 = transmit(0xff);
+    }
+    
+    return r1;
+}
+
+/**
+ * Sends the given application specific command with the given argument 
+ * and returns the R1 response.
+ * @param cmd
+ * @param arg
+ * @return R1 response
+ */
+static uint8_t appCommand(uint8_t cmd, uint32_t arg) {
+    command(SD_APP_CMD, 0);
+    
+    return command(cmd, arg);
+}
+
+/**
+ * Waits until the card releases DO, i.e. is no longer busy.
+ * @return true if the card is ready, false on timeout
+ */
+static bool waitReady(void) {
+    for (uint16_t i = 0; i < SD_RETRIES; i++) {
+        if (transmit(0xff) == 0xff) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+/**
+ * Returns the address argument for the given block.
+ * @param block
+ * @return address
+ */
+static uint32_t address(uint32_t block) {
+    return blockAddressing ? block : block * SD_BLOCK;
+}
+
+/**
+ * Does the initialization sequence with the card selected.
+ * @return true if the card is ready, false otherwise
+ */
+static bool init(void) {
+    if (command(SD_GO_IDLE_STATE, 0) != SD_R1_IDLE) {
+        return false;
+    }
+    
+    // version 2 cards echo the check pattern
+    bool v2 = false;
+    if (command(SD_SEND_IF_COND, 0x1aa) == SD_R1_IDLE) {
+        uint8_t r7[4];
+        receive(r7, sizeof (r7));
+        if (r7[3] != 0xaa) {
+            return false;
+        }
+        v2 = true;
+    }
+    
+    // initialization may take up to one second
+    uint8_t r1 = SD_R1_IDLE;
+    for (uint16_t i = 0; i < 1000 && r1 == SD_R1_IDLE; i++) {
+        r1 = appCommand(SD_APP_SEND_OP_COND, v2 ? (1UL << 30) : 0);
+        if (r1 == SD_R1_IDLE) {
+            _delay_ms(1);
+        }
+    }
+    if (r1 != 0x00) {
+        return false;
+    }
+    
+    blockAddressing = false;
+    if (v2) {
+        if (command(SD_READ_OCR, 0) != 0x00) {
+            return false;
+        }
+        uint8_t ocr[4];
+        receive(ocr, sizeof (ocr));
+        // card capacity status
+        blockAddressing = ocr[0] & 0x40;
+    }
+    if (!blockAddressing) {
+        return command(SD_SET_BLOCKLEN, SD_BLOCK) == 0x00;
+    }
+    
+    return true;
+}
+
+bool sdInit(void) {
+    // at least 74 clocks with CS and DI high to enter native mode
+    spiBegin(SPI_SD_INIT);
+    sdDes();
+    transmitRepeat(0xff, 10);
+    sdSel();
+    bool ready = init();
+    spiEnd(SPI_SD_INIT);
+    
+    return ready;
+}
+
+bool sdReadBegin(uint32_t block) {
+    position = 0;
+    spiBegin(SPI_SD);
+    if (command(SD_READ_SINGLE_BLOCK, address(block)) == 0x00) {
+        uint8_t token = 0xff;
+        for (uint16_t i = 0; i < SD_RETRIES && token == 0xff; i++) {
+            token = transmit(0xff);
+        }
+        if (token == SD_START_BLOCK) {
+            return true;
+        }
+    }
+    spiEnd(SPI_SD);
+    
+    return false;
+}
+
+void sdRead(uint8_t *data, uint16_t length) {
+    position += length;
+    if (data == NULL) {
+        transmitRepeat(0xff, length);
+    } else {
+        receive(data, length);
+    }
+}
+
+void sdReadEnd(void) {
+    // skip the rest and ignore CRC
+    transmitRepeat(0xff, SD_BLOCK - position + 2);
+    spiEnd(SPI_SD);
+}
+
+bool sdReadPart(uint32_t block, uint16_t offset, uint8_t *data, uint16_t length) {
+    if (!sdReadBegin(block)) {
+        return false;
+    }
+    sdRead(NULL, offset);
+    sdRead(data, length);
+    sdReadEnd();
+    
+    return true;
+}
+
+bool sdWriteBegin(uint32_t block) {
+    position = 0;
+    spiBegin(SPI_SD);
+    if (command(SD_WRITE_BLOCK, address(block)) == 0x00) {
+        transmit(0xff);
+        transmit(SD_START_BLOCK);
+        return true;
+    }
+    spiEnd(SPI_SD);
+    
+    return false;
+}
+
+void sdWrite(const uint8_t *data, uint16_t length) {
+    position += length;
+    transmitBytes(data, length);
+}
+
+bool sdWriteEnd(void) {
+    transmitRepeat(0x00, SD_BLOCK - position);
+    // dummy CRC
+    transmitRepeat(0xff, 2);
+    uint8_t response = transmit(0xff) & SD_DATA_MASK;
+    // the card holds DO low while programming
+    bool written = response == SD_DATA_ACCEPT && waitReady();
+    spiEnd(SPI_SD);
+    
+    return written;
+}
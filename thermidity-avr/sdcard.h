@@ -0,0 +1,99 @@
+/* 
+ * File:   sdcard.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 16:58
+ */
+
+#ifndef SDCARD_H
+#define SDCARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Size of a block in bytes */
+#define SD_BLOCK    512
+
+/** Commands in SPI mode */
+#define SD_GO_IDLE_STATE        0
+#define SD_SEND_IF_COND         8
+#define SD_SET_BLOCKLEN         16
+#define SD_READ_SINGLE_BLOCK    17
+#define SD_WRITE_BLOCK          24
+#define SD_APP_CMD              55
+#define SD_READ_OCR             58
+#define SD_APP_SEND_OP_COND     41
+
+/** R1 response bits */
+#define SD_R1_IDLE      0x01
+#define SD_R1_ILLEGAL   0x04
+
+/** Tokens */
+#define SD_START_BLOCK  0xfe
+#define SD_DATA_MASK    0x1f
+#define SD_DATA_ACCEPT  0x05
+
+/**
+ * Initializes the SD card after it was powered on, at a slow clock,
+ * and then switches to the fast clock.
+ * @return true if the card is ready, false otherwise
+ */
+bool sdInit(void);
+
+/**
+ * Starts reading the block with the given number, keeping the card 
+ * selected until sdReadEnd() is called.
+ * @param block
+ * @return true if the card sent the block, false otherwise
+ */
+bool sdReadBegin(uint32_t block);
+
+/**
+ * Receives the given number of bytes of the block being read into the 
+ * given buffer, or skips them if the buffer is NULL.
+ * @param data
+ * @param length
+ */
+void sdRead(uint8_t *data, uint16_t length);
+
+/**
+ * Skips the rest of the block being read and deselects the card.
+ */
+void sdReadEnd(void);
+
+/**
+ * Reads the given number of bytes at the given offset of the block with
+ * the given number into the given buffer.
+ * @param block
+ * @param offset
+ * @param data
+ * @param length
+ * @return true on success, false otherwise
+ */
+bool sdReadPart(uint32_t block, uint16_t offset, uint8_t *data, uint16_t length);
+
+/**
+ * Starts writing the block with the given number, keeping the card 
+ * selected until sdWriteEnd() is called, as the card expects the whole 
+ * block in one transaction.
+ * @param block
+ * @return true if the card accepted the command, false otherwise
+ */
+bool sdWriteBegin(uint32_t block);
+
+/**
+ * Transmits the given number of bytes from the given buffer to the block
+ * being written.
+ * @param data
+ * @param length
+ */
+void sdWrite(const uint8_t *data, uint16_t length);
+
+/**
+ * Fills the rest of the block being written with zeros, waits until the
+ * card is done programming and deselects it.
+ * @return true if the block was written, false otherwise
+ */
+bool sdWriteEnd(void);
+
+#endif /* SDCARD_H */
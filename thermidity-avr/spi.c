@@ -9,6 +9,23 @@
 #include <avr/io.h>
 #include "pins.h"
 #include "spi.h"
+#include "power.h"
+
+#define SPCR_PROFILE ((1 << SPR1) | (1 << SPR0) | (1 << CPOL) | (1 << CPHA) | (1 << DORD))
+
+/* Clock and mode of each device, mode 0 and fosc/2 except fosc/32 for SD init */
+static const __flash SPIProfile profiles[] = {
+    [SPI_SRAM]    = {0, (1 << SPI2X)},
+    [SPI_DISPLAY] = {0, (1 << SPI2X)},
+    [SPI_SD_INIT] = {(1 << SPR1), (1 << SPI2X)},
+    [SPI_SD]      = {0, (1 << SPI2X)}
+};
+
+/* Device whose profile is currently applied */
+static uint8_t applied = 0xff;
+
+/* If bytes transmitted via MSPIM may still be being shifted out */
+static bool mspimPending = false;
 
 void sramSel(void) {
     PORT_SSPI &= ~(1 << PIN_SRCS);
@@ -26,9 +43,156 @@ void displayDes(void) {
     PORT_DSPI |= (1 << PIN_ECS);
 }
 
+void sdSel(void) {
+    PORT_SD &= ~(1 << PIN_SDCS);
+}
+
+void sdDes(void) {
+    PORT_SD |= (1 << PIN_SDCS);
+}
+
+void spiBegin(uint8_t device) {
+    if (device != applied) {
+        const __flash SPIProfile *profile = &profiles[device];
+        SPCR = (SPCR & ~SPCR_PROFILE) | profile->spcr;
+        SPSR = profile->spsr;
+        applied = device;
+    }
+    
+    if (device == SPI_SRAM) {
+        sramSel();
+    } else if (device == SPI_DISPLAY) {
+        displaySel();
+    } else {
+        sdSel();
+    }
+}
+
+void spiEnd(uint8_t device) {
+    if (device == SPI_SRAM) {
+        sramDes();
+    } else if (device == SPI_DISPLAY) {
+        displayFlush();
+        displayDes();
+    } else {
+        sdDes();
+        // the card releases DO only with the next clock
+        transmit(0xff);
+    }
+}
+
 uint8_t transmit(uint8_t data) {
     SPDR = data;
     loop_until_bit_is_set(SPSR, SPIF);
 
     return SPDR;
-}
\ No newline at end of file
+}
+
+void transmitBytes(const uint8_t *data, uint16_t length) {
+    if (length == 0) {
+        return;
+    }
+    uint8_t next = *data++;
+    while (length-- > 0) {
+        SPDR = next;
+        if (length > 0) {
+            next = *data++;
+        }
+        loop_until_bit_is_set(SPSR, SPIF);
+    }
+}
+
+void transmitFlash(const __flash uint8_t *data, uint16_t length) {
+    if (length == 0) {
+        return;
+    }
+    uint8_t next = *data++;
+    while (length-- > 0) {
+        SPDR = next;
+        if (length > 0) {
+            next = *data++;
+        }
+        loop_until_bit_is_set(SPSR, SPIF);
+    }
+}
+
+void transmitRepeat(uint8_t data, uint16_t length) {
+    while (length-- > 0) {
+        SPDR = data;
+        loop_until_bit_is_set(SPSR, SPIF);
+    }
+}
+
+void receiveBytes(uint8_t *data, uint16_t length) {
+    while (length-- > 0) {
+        SPDR = 0;
+        loop_until_bit_is_set(SPSR, SPIF);
+        *data++ = SPDR;
+    }
+}
+
+void displayTransmit(uint8_t data) {
+#if DISPLAY_MSPIM
+    loop_until_bit_is_set(UCSR0A, UDRE0);
+    UDR0 = data;
+    // clear the transmit complete flag only now that the buffer is not 
+    // empty, so a previous byte shifted out cannot set it again
+    UCSR0A = (1 << TXC0);
+    mspimPending = true;
+#else
+    transmit(data);
+#endif
+}
+
+void displayTransmitBytes(const uint8_t *data, uint16_t length) {
+#if DISPLAY_MSPIM
+    while (length-- > 0) {
+        displayTransmit(*data++);
+    }
+#else
+    transmitBytes(data, length);
+#endif
+}
+
+#if DISPLAY_MSPIM
+void displayRelay(uint16_t length) {
+    if (length == 0) {
+        return;
+    }
+    SPDR = 0x00;
+    while (length-- > 0) {
+        loop_until_bit_is_set(SPSR, SPIF);
+        uint8_t data = SPDR;
+        if (length > 0) {
+            // receive the next byte while this one is being transmitted
+            SPDR = 0x00;
+        }
+        displayTransmit(data);
+    }
+}
+#endif
+
+void displayFlush(void) {
+    if (mspimPending) {
+        loop_until_bit_is_set(UCSR0A, TXC0);
+        mspimPending = false;
+    }
+}
+
+void enableMSPIM(void) {
+    powerOn(POWER_USART);
+    // baud rate register must be zero when enabling the transmitter,
+    // and stays zero for fosc/2
+    UBRR0 = 0;
+    DDR_MSPIM |= (1 << PIN_XCK);
+    // Master SPI Mode, mode 0, MSB first
+    UCSR0C = (1 << UMSEL01) | (1 << UMSEL00);
+    UCSR0B = (1 << TXEN0);
+}
+
+void disableMSPIM(void) {
+    displayFlush();
+    UCSR0B = 0;
+    PORT_MSPIM &= ~(1 << PIN_XCK);
+    powerOff(POWER_USART);
+}
@@ -8,6 +8,37 @@
 #ifndef SPI_H
 #define SPI_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
+/** SRAM 23K640, max. 20 MHz, mode 0 */
+#define SPI_SRAM    0
+/** Display SSD1680, max. 20 MHz for writing, mode 0 */
+#define SPI_DISPLAY 1
+/** SD card during initialization, max. 400 kHz, mode 0 */
+#define SPI_SD_INIT 2
+/** SD card, max. 25 MHz, mode 0 */
+#define SPI_SD      3
+
+/** 
+ * Write to the display via USART0 in Master SPI Mode with its double 
+ * buffered transmitter, with SCK and MOSI of the display wired to 
+ * PIN_XCK and PIN_TXD, and the USART not available for printing 
+ */
+#ifndef DISPLAY_MSPIM
+#define DISPLAY_MSPIM   0
+#endif
+
+/**
+ * Clock and mode of a device on the SPI bus.
+ */
+typedef struct {
+    /** Bits SPR1, SPR0, CPOL, CPHA and DORD of SPCR. */
+    const uint8_t spcr;
+    /** Bit SPI2X of SPSR. */
+    const uint8_t spsr;
+} SPIProfile;
+
 /**
  * Selects the SRAM to talk to via SPI.
  */
@@ -28,6 +59,29 @@ void displaySel(void);
  */
 void displayDes(void);
 
+/**
+ * Selects the SD card to talk to via SPI.
+ */
+void sdSel(void);
+
+/**
+ * Deselects the SD card to talk to via SPI.
+ */
+void sdDes(void);
+
+/**
+ * Begins a transaction with the given device by applying its clock and
+ * mode, if not already applied, and selecting it.
+ * @param device one of SPI_SRAM, SPI_DISPLAY, SPI_SD_INIT or SPI_SD
+ */
+void spiBegin(uint8_t device);
+
+/**
+ * Ends a transaction with the given device by deselecting it.
+ * @param device one of SPI_SRAM, SPI_DISPLAY, SPI_SD_INIT or SPI_SD
+ */
+void spiEnd(uint8_t device);
+
 /**
  * Transmits the given byte and returns the byte reveived at the same time.
  * @param data byte to be written
@@ -35,5 +89,75 @@ void displayDes(void);
  */
 uint8_t transmit(uint8_t data);
 
+/**
+ * Transmits the given number of bytes from the given buffer, fetching
+ * the next byte while the current one is being shifted out.
+ * @param data
+ * @param length
+ */
+void transmitBytes(const uint8_t *data, uint16_t length);
+
+/**
+ * Transmits the given number of bytes from the given buffer in program
+ * memory, fetching the next byte while the current one is being shifted out.
+ * @param data
+ * @param length
+ */
+void transmitFlash(const __flash uint8_t *data, uint16_t length);
+
+/**
+ * Transmits the given byte the given number of times.
+ * @param data
+ * @param length
+ */
+void transmitRepeat(uint8_t data, uint16_t length);
+
+/**
+ * Receives the given number of bytes into the given buffer.
+ * @param data
+ * @param length
+ */
+void receiveBytes(uint8_t *data, uint16_t length);
+
+/**
+ * Transmits the given byte to the display, via SPI or via USART0 in 
+ * Master SPI Mode, in which case the byte may still be being shifted out 
+ * when this function returns.
+ * @param data
+ */
+void displayTransmit(uint8_t data);
+
+/**
+ * Transmits the given number of bytes from the given buffer to the display.
+ * @param data
+ * @param length
+ */
+void displayTransmitBytes(const uint8_t *data, uint16_t length);
+
+#if DISPLAY_MSPIM
+/**
+ * Receives the given number of bytes via SPI from the selected device and 
+ * transmits them to the display via USART0 in Master SPI Mode, receiving 
+ * each byte while the previous one is being transmitted.
+ * @param length
+ */
+void displayRelay(uint16_t length);
+#endif
+
+/**
+ * Waits until all bytes transmitted to the display are shifted out.
+ */
+void displayFlush(void);
+
+/**
+ * Enables USART0 in Master SPI Mode at fosc/2, mode 0.
+ */
+void enableMSPIM(void);
+
+/**
+ * Disables USART0 and stops its clock.
+ */
+void disableMSPIM(void);
+
 #endif /* SPI_H */
 
@@ -11,16 +11,60 @@
 #include "sram.h"
 #include "spi.h"
 
-void sramWrite(uint16_t address, uint8_t data) {
-    sramSel();
-    transmit(SRAM_WRITE);
+/* Start and size of each region, allocated one after the other */
+static sramaddr_t starts[SRAM_REGIONS];
+static sramaddr_t sizes[SRAM_REGIONS];
+static sramaddr_t allocated = 0;
+
+/**
+ * Transmits the given address, 24 or 16 bits MSB first.
+ * @param address
+ */
+static void transmitAddress(sramaddr_t address) {
+#if SRAM_23LC1024
+    transmit(address >> 16);
+#endif
     transmit(address >> 8);
     transmit(address);
+}
+
+bool sramAlloc(uint8_t region, sramaddr_t size) {
+    if (region >= SRAM_REGIONS || sizes[region] > 0) {
+        return false;
+    }
+    
+    sramaddr_t left = SRAM_HIGH - allocated + 1;
+    if (allocated > SRAM_HIGH || size > left) {
+        return false;
+    }
+    if (size == 0) {
+        size = left;
+    }
+    
+    starts[region] = allocated;
+    sizes[region] = size;
+    allocated += size;
+    
+    return true;
+}
+
+sramaddr_t sramStart(uint8_t region) {
+    return starts[region];
+}
+
+sramaddr_t sramSize(uint8_t region) {
+    return sizes[region];
+}
+
+void sramWrite(sramaddr_t address, uint8_t data) {
+    spiBegin(SPI_SRAM);
+    transmit(SRAM_WRITE);
+    transmitAddress(address);
     transmit(data);
-    sramDes();
+    spiEnd(SPI_SRAM);
 }
 
-size_t sramWriteString(uint16_t address, const char *data) {
+size_t sramWriteString(sramaddr_t address, const char *data) {
     size_t written = 0;
     for (; address <= SRAM_HIGH; ++address) {
         char c = *data++;
@@ -34,18 +78,17 @@ size_t sramWriteString(uint16_t address, const char *data) {
     return written;
 }
 
-uint8_t sramRead(uint16_t address) {
-    sramSel();
+uint8_t sramRead(sramaddr_t address) {
+    spiBegin(SPI_SRAM);
     transmit(SRAM_READ);
-    transmit(address >> 8);
-    transmit(address);
+    transmitAddress(address);
     uint8_t read = transmit(0);
-    sramDes();
+    spiEnd(SPI_SRAM);
 
     return read;
 }
 
-void sramReadString(uint16_t address, char *buf, size_t length) {
+void sramReadString(sramaddr_t address, char *buf, size_t length) {
     for (size_t i = 0; i < length - 1; i++) {
         if (address > SRAM_HIGH) {
             break;
@@ -56,29 +99,27 @@ void sramReadString(uint16_t address, char *buf, size_t length) {
 }
 
 void sramWriteStatus(uint8_t status) {
-    sramSel();
+    spiBegin(SPI_SRAM);
     transmit(SRAM_WRSR);
     transmit(status);
-    sramDes();
+    spiEnd(SPI_SRAM);
 }
 
 uint8_t sramReadStatus(void) {
-    sramSel();
+    spiBegin(SPI_SRAM);
     transmit(SRAM_RDSR);
     uint8_t status = transmit(0);
-    sramDes();
+    spiEnd(SPI_SRAM);
 
     return status;
 }
 
-void sramInitWrite(uint16_t address) {
+void sramInitWrite(sramaddr_t address) {
     transmit(SRAM_WRITE);
-    transmit(address >> 8);
-    transmit(address);    
+    transmitAddress(address);
 }
 
-void sramInitRead(uint16_t address) {
+void sramInitRead(sramaddr_t address) {
     transmit(SRAM_READ);
-    transmit(address >> 8);
-    transmit(address);    
-}
\ No newline at end of file
+    transmitAddress(address);
+}
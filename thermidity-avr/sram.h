@@ -8,23 +8,79 @@
 #ifndef SRAM_H
 #define SRAM_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+/** SRAM is a 128 KB 23LC1024 with 24-bit addresses instead of a 23K640 */
+#ifndef SRAM_23LC1024
+#define SRAM_23LC1024 0
+#endif
+
 #define SRAM_READ   0x3
 #define SRAM_WRITE  0x2
 #define SRAM_RDSR   0x5
 #define SRAM_WRSR   0x1
 
+#if SRAM_23LC1024
+#define SRAM_BYTE   0x00
+#define SRAM_SEQU   0x40
+#define SRAM_PAGE   0x80
+
+#define SRAM_HIGH   0x1ffffUL
+
+/* SRAM address */
+typedef uint32_t sramaddr_t;
+#else
 #define SRAM_BYTE   0x01
 #define SRAM_SEQU   0x41
 #define SRAM_PAGE   0x81
 
 #define SRAM_HIGH   0x1fff
 
+/* SRAM address */
+typedef uint16_t sramaddr_t;
+#endif
+
+#define SRAM_SIZE   (SRAM_HIGH + 1)
+
+/* Regions of the SRAM */
+#define SRAM_FRAME      0 // frame buffer
+#define SRAM_PREV_FRAME 1 // previously displayed frame
+#define SRAM_BACKGROUND 2 // static background of the frame
+#define SRAM_HISTORY    3 // history log
+#define SRAM_LOG        4 // SD card log buffer
+#define SRAM_REGIONS    5
+
+/**
+ * Allocates the given number of bytes for the given region right after
+ * the regions allocated before, or all bytes left if the size is 0.
+ * A region can only be allocated once.
+ * @param region
+ * @param size
+ * @return true if the region was allocated, false otherwise
+ */
+bool sramAlloc(uint8_t region, sramaddr_t size);
+
+/**
+ * Returns the start address of the given region.
+ * @param region
+ * @return start address
+ */
+sramaddr_t sramStart(uint8_t region);
+
+/**
+ * Returns the size of the given region, 0 if it is not allocated.
+ * @param region
+ * @return size
+ */
+sramaddr_t sramSize(uint8_t region);
+
 /**
  * Writes the given byte to the given address.
  * @param address
  * @param data
  */
-void sramWrite(uint16_t address, uint8_t data);
+void sramWrite(sramaddr_t address, uint8_t data);
 
 /**
  * Writes the given string starting at the given address, never beyond
@@ -34,14 +90,14 @@ void sramWrite(uint16_t address, uint8_t data);
  * @param data
  * @return number of bytes written
  */
-size_t sramWriteString(uint16_t address, const char *data);
+size_t sramWriteString(sramaddr_t address, const char *data);
 
 /**
  * Reads the byte at the given address and returns it.
  * @param address
  * @return byte
  */
-uint8_t sramRead(uint16_t address);
+uint8_t sramRead(sramaddr_t address);
 
 /**
  * Reads length - 1 bytes starting at the given address, never beyond 
@@ -51,7 +107,7 @@ uint8_t sramRead(uint16_t address);
  * @param string
  * @param length
  */
-void sramReadString(uint16_t address, char *string, size_t length);
+void sramReadString(sramaddr_t address, char *string, size_t length);
 
 /**
  * Writes the given status.
@@ -70,14 +126,14 @@ uint8_t sramReadStatus(void);
  * Useful for writing in sequential or page mode.
  * @param address
  */
-void sramInitWrite(uint16_t address);
+void sramInitWrite(sramaddr_t address);
 
 /**
  * Sends read command and sets the given address.
  * Useful for reading in sequential or page mode.
  * @param address
  */
-void sramInitRead(uint16_t address);
+void sramInitRead(sramaddr_t address);
 
 #endif /* SRAM_H */
 
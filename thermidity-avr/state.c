@@ -0,0 +1,123 @@
+/* 
+ * File:   state.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:05
+ */
+
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "state.h"
+#include "meter.h"
+#include "config.h"
+#include "battery.h"
+
+/**
+ * A checkpoint as stored in a slot in the EEPROM.
+ */
+typedef struct {
+    /** Incremented with each checkpoint. */
+    uint16_t seq;
+    /** Weight of the average the state was saved with. */
+    uint8_t ewmaBs;
+    /** Number of fast updates since the last full update. */
+    uint8_t updates;
+    MeterState meter;
+    BatteryState battery;
+    uint16_t crc;
+} Checkpoint;
+
+/* 
+ * The checkpoints are written to the slots in turn, so each slot is
+ * written only every STATE_SLOTS checkpoints.
+ */
+static Checkpoint EEMEM slots[STATE_SLOTS];
+
+_Static_assert(sizeof (slots) + sizeof (ConfigBlock) <= E2END + 1, 
+        "checkpoints and configuration do not fit in the EEPROM");
+
+/* Slot written last and its sequence number */
+static uint8_t slot = STATE_SLOTS - 1;
+static uint16_t seq = 0;
+
+/* Display update intervals since the last checkpoint */
+static uint8_t intervals = 0;
+
+/**
+ * Calculates the CRC of the given checkpoint without its CRC.
+ * @param checkpoint
+ * @return CRC
+ */
+static uint16_t calcCRC(const Checkpoint *checkpoint) {
+    const uint8_t *data = (const uint8_t *)checkpoint;
+    uint16_t crc = 0xffff;
+    for (uint8_t i = 0; i < offsetof(Checkpoint, crc); i++) {
+        crc = _crc16_update(crc, data[i]);
+    }
+    
+    return crc;
+}
+
+/**
+ * Reads the checkpoint in the given slot.
+ * @param index
+ * @param checkpoint
+ * @return true if the checkpoint is valid, false otherwise
+ */
+static bool readSlot(uint8_t index, Checkpoint *checkpoint) {
+    eeprom_read_block(checkpoint, &slots[index], sizeof (Checkpoint));
+    
+    return checkpoint->crc == calcCRC(checkpoint);
+}
+
+void checkpointState(uint8_t updates) {
+    if (++intervals >= STATE_INTERVAL) {
+        saveState(updates);
+    }
+}
+
+void saveState(uint8_t updates) {
+    Checkpoint checkpoint = {
+        .seq = ++seq, 
+        .ewmaBs = config.ewmaBs, 
+        .updates = updates
+    };
+    getMeterState(&checkpoint.meter);
+    getBatteryState(&checkpoint.battery);
+    checkpoint.crc = calcCRC(&checkpoint);
+    
+    slot = (slot + 1) % STATE_SLOTS;
+    eeprom_update_block(&checkpoint, &slots[slot], sizeof (Checkpoint));
+    intervals = 0;
+}
+
+bool restoreState(uint8_t *updates) {
+    // the most recent checkpoint is the one not followed by its successor
+    Checkpoint checkpoint;
+    Checkpoint next;
+    bool valid = readSlot(0, &next);
+    for (uint8_t i = 0; i < STATE_SLOTS; i++) {
+        checkpoint = next;
+        bool current = valid;
+        valid = readSlot((i + 1) % STATE_SLOTS, &next);
+        if (current && (!valid || next.seq != (uint16_t)(checkpoint.seq + 1))) {
+            // continue with the next slot even if the state is not restored
+            slot = i;
+            seq = checkpoint.seq;
+            // the consumed charge does not depend on the average
+            setBatteryState(&checkpoint.battery, 
+                    checkpoint.meter.avgMVBat >> checkpoint.ewmaBs);
+            if (checkpoint.ewmaBs != config.ewmaBs) {
+                return false;
+            }
+            *updates = checkpoint.updates;
+            setMeterState(&checkpoint.meter);
+            
+            return true;
+        }
+    }
+    
+    return false;
+}
@@ -0,0 +1,48 @@
+/* 
+ * File:   state.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:05
+ */
+
+#ifndef STATE_H
+#define STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** 
+ * Number of slots in the EEPROM the checkpoints are written to in turn,
+ * as many as fit next to the configuration
+ */
+#define STATE_SLOTS     30
+
+/** Number of display update intervals between checkpoints, ~1 hour */
+#define STATE_INTERVAL  12
+
+/**
+ * Counts display update intervals and writes a checkpoint of the state 
+ * every STATE_INTERVAL intervals.
+ * @param updates number of fast updates since the last full update
+ */
+void checkpointState(uint8_t updates);
+
+/**
+ * Writes a checkpoint of the measurement state, last displayed values, 
+ * consumed battery charge and the given number of fast updates since the 
+ * last full update to the next slot in the EEPROM.
+ * @param updates
+ */
+void saveState(uint8_t updates);
+
+/**
+ * Restores the state from the most recent valid checkpoint in the EEPROM,
+ * the measurement state only if it was saved with the current weight of 
+ * the average. The restored averages are verified with the next 
+ * measurement, as is the battery voltage to detect replaced batteries.
+ * @param updates set to the restored number of fast updates
+ * @return true if the state was restored, false otherwise
+ */
+bool restoreState(uint8_t *updates);
+
+#endif /* STATE_H */
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+#
+# File:   mkimg.py
+# Author: agent@local
+#
+# Created on 18. October 2026, 17:37
+#
+# Creates a card image with a FAT16 or FAT32 volume, with or without MBR,
+# holding a preallocated and fragmented THERMID.LOG in the root directory
+# after some other and deleted entries, and writes the blocks of the file
+# in order to <image>.json for verify.py.
+#
+# Usage: mkimg.py image fat16|fat32 mbr clusters
+
+import json
+import struct
+import sys
+
+BLOCK = 512
+
+path, fat, mbr, clusters = sys.argv[1], sys.argv[2], int(sys.argv[3]), int(sys.argv[4])
+fat16 = fat == 'fat16'
+
+if fat16:
+    spc, total, rootEntries, reserved, entrySize, eoc = 4, 6000, 512, 4, 2, 0xffff
+else:
+    spc, total, rootEntries, reserved, entrySize, eoc = 1, 70000, 0, 32, 4, 0x0fffffff
+fats = 2
+volume = 2048 if mbr else 0
+fatSize = (total + 2) * entrySize // BLOCK + 1
+data = reserved + fats * fatSize + rootEntries * 32 // BLOCK
+blocks = data + total * spc
+image = bytearray((volume + blocks) * BLOCK)
+
+# boot sector with BPB
+boot = bytearray(BLOCK)
+boot[0:11] = b'\xeb\x3c\x90MSWIN4.1'
+small = fat16 and blocks < 65536
+struct.pack_into('<HBHBHHBH', boot, 11, BLOCK, spc, reserved, fats,
+                 rootEntries, blocks if small else 0, 0xf8,
+                 fatSize if fat16 else 0)
+struct.pack_into('<I', boot, 32, 0 if small else blocks)
+if not fat16:
+    # FAT size, flags and version, root directory cluster
+    struct.pack_into('<IHHI', boot, 36, fatSize, 0, 0, 2)
+boot[510:512] = b'\x55\xaa'
+image[volume * BLOCK:(volume + 1) * BLOCK] = boot
+
+# partition table with one partition
+if mbr:
+    image[446 + 4] = 0x06 if fat16 else 0x0c
+    struct.pack_into('<II', image, 446 + 8, volume, blocks)
+    image[510:512] = b'\x55\xaa'
+
+table = {}
+free = 2
+root = []
+if not fat16:
+    # root directory spanning two clusters
+    root = [2, 3]
+    table.update({2: 3, 3: eoc})
+    free = 4
+
+# fragmented chain of the log file after some clusters of other files
+chain = []
+cluster = free + 5
+while len(chain) < clusters:
+    chain.append(cluster)
+    cluster += 1 if len(chain) % 3 else 2
+table.update(zip(chain, chain[1:]))
+table[chain[-1]] = eoc
+
+for i in range(fats):
+    base = (volume + reserved + i * fatSize) * BLOCK
+    for index, value in table.items():
+        struct.pack_into('<H' if fat16 else '<I', image,
+                         base + index * entrySize, value)
+
+
+def entry(name, attr, cluster, size):
+    entry = bytearray(32)
+    entry[0:11] = name
+    entry[11] = attr
+    struct.pack_into('<H', entry, 20, cluster >> 16)
+    struct.pack_into('<H', entry, 26, cluster & 0xffff)
+    struct.pack_into('<I', entry, 28, size)
+    return entry
+
+
+# file size not aligned to clusters
+size = clusters * spc * BLOCK - 3 * BLOCK
+entries = [entry(b'THERMIDITY ', 0x08, 0, 0),
+           entry(b'\x41t\x00h\x00e\x00r\x00m\x00', 0x0f, 0, 0)]
+entries += [entry(b'OTHER   TXT', 0x20, free, 100)] * 20
+entries += [entry(b'\xe5HERMID LOG', 0x20, free + 1, 1000)]
+entries += [entry(b'THERMID LOG', 0x20, chain[0], size)]
+raw = b''.join(entries)
+
+if fat16:
+    offset = (volume + reserved + fats * fatSize) * BLOCK
+    image[offset:offset + len(raw)] = raw
+else:
+    for i in range(0, len(raw), BLOCK):
+        cluster = root[i // BLOCK]
+        offset = (volume + data + (cluster - 2) * spc) * BLOCK
+        part = raw[i:i + BLOCK]
+        image[offset:offset + len(part)] = part
+
+with open(path, 'wb') as file:
+    file.write(image)
+
+log = [volume + data + (c - 2) * spc + j for c in chain for j in range(spc)]
+with open(path + '.json', 'w') as file:
+    json.dump(log[:size // BLOCK], file)
@@ -0,0 +1,362 @@
+/* 
+ * File:   sdemu.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:37
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sdemu.h"
+#include "spi.h"
+#include "sram.h"
+#include "sdcard.h"
+
+/*
+ * Host stand-in for spi.c with an emulated SPI SRAM and SD card in SPI 
+ * mode on the bus, the card being backed by an image file.
+ */
+
+/* Device selected on the bus */
+#define SEL_NONE    0
+#define SEL_SRAM    1
+#define SEL_SD      2
+
+/* Number of ACMD41 until the card leaves the idle state */
+#define SD_INIT_TRIES   3
+/* Number of bytes the card is busy programming a block */
+#define SD_BUSY_BYTES   4
+
+/* Phase of the card */
+#define SD_COMMAND  0 // receiving a command
+#define SD_TOKEN    1 // waiting for the start block token to write
+#define SD_DATA     2 // receiving the block and CRC to write
+
+static uint8_t selected = SEL_NONE;
+
+/* SRAM contents and transaction state */
+static uint8_t sram[SRAM_SIZE];
+static uint8_t sramMode = SRAM_BYTE;
+static uint8_t sramCmd;
+static uint8_t sramAddrBytes;
+static uint32_t sramAddr;
+
+/* Card image and state */
+static FILE *image = NULL;
+static bool blockAddressing;
+static bool idle;
+static bool app;
+static uint8_t initTries;
+static uint8_t phase;
+static uint8_t frame[6];
+static uint8_t framed;
+static uint8_t data[SD_BLOCK + 2];
+static uint16_t received;
+static uint32_t writeBlock;
+static long writes = 0;
+static long violations = 0;
+
+/* Bytes the card sends next */
+static uint8_t out[SD_BLOCK + 16];
+static uint16_t outHead;
+static uint16_t outLength;
+
+/**
+ * Queues the given byte to be sent by the card.
+ * @param byte
+ */
+static void send(uint8_t byte) {
+    out[outLength++] = byte;
+}
+
+/**
+ * Returns the block addressed by the given command argument.
+ * @param arg
+ * @return block
+ */
+static uint32_t argBlock(uint32_t arg) {
+    return blockAddressing ? arg : arg / SD_BLOCK;
+}
+
+/**
+ * Handles the command in the frame received by the card.
+ */
+static void command(void) {
+    uint8_t cmd = frame[0] & 0x3f;
+    uint32_t arg = ((uint32_t) frame[1] << 24) | ((uint32_t) frame[2] << 16) |
+            ((uint32_t) frame[3] << 8) | frame[4];
+    uint8_t r1 = idle ? SD_R1_IDLE : 0x00;
+    
+    // one byte of response time
+    send(0xff);
+    
+    if (app) {
+        app = false;
+        if (cmd == SD_APP_SEND_OP_COND) {
+            if (++initTries >= SD_INIT_TRIES) {
+                idle = false;
+            }
+            send(idle ? SD_R1_IDLE : 0x00);
+        } else {
+            send(r1 | SD_R1_ILLEGAL);
+        }
+        return;
+    }
+    
+    switch (cmd) {
+        case SD_GO_IDLE_STATE:
+            idle = true;
+            initTries = 0;
+            send(frame[5] == 0x95 ? SD_R1_IDLE : SD_R1_IDLE | 0x08);
+            break;
+        case SD_SEND_IF_COND:
+            if (!blockAddressing) {
+                // version 1 cards do not know CMD8
+                send(r1 | SD_R1_ILLEGAL);
+                break;
+            }
+            send(r1);
+            send(0x00);
+            send(0x00);
+            send(0x01);
+            send(arg & 0xff);
+            break;
+        case SD_APP_CMD:
+            app = true;
+            send(r1);
+            break;
+        case SD_READ_OCR:
+            send(r1);
+            send(blockAddressing ? 0xc0 : 0x80);
+            send(0xff);
+            send(0x80);
+            send(0x00);
+            break;
+        case SD_SET_BLOCKLEN:
+            send(arg == SD_BLOCK ? r1 : r1 | 0x40);
+            break;
+        case SD_READ_SINGLE_BLOCK: {
+            send(r1);
+            send(0xff);
+            send(SD_START_BLOCK);
+            uint8_t block[SD_BLOCK] = {0};
+            fseek(image, (long) argBlock(arg) * SD_BLOCK, SEEK_SET);
+            if (fread(block, 1, SD_BLOCK, image) != SD_BLOCK) {
+                memset(block, 0, SD_BLOCK);
+            }
+            for (uint16_t i = 0; i < SD_BLOCK; i++) {
+                send(block[i]);
+            }
+            send(0x00);
+            send(0x00);
+            break;
+        }
+        case SD_WRITE_BLOCK:
+            send(r1);
+            writeBlock = argBlock(arg);
+            phase = SD_TOKEN;
+            break;
+        default:
+            send(r1 | SD_R1_ILLEGAL);
+    }
+}
+
+/**
+ * Exchanges the given byte with the card.
+ * @param byte
+ * @return byte sent by the card
+ */
+static uint8_t sdTransmit(uint8_t byte) {
+    if (outHead < outLength) {
+        uint8_t next = out[outHead++];
+        if (outHead == outLength) {
+            outHead = outLength = 0;
+        }
+        return next;
+    }
+    
+    if (phase == SD_TOKEN) {
+        if (byte == SD_START_BLOCK) {
+            phase = SD_DATA;
+            received = 0;
+        }
+        return 0xff;
+    }
+    if (phase == SD_DATA) {
+        data[received++] = byte;
+        if (received == sizeof (data)) {
+            fseek(image, (long) writeBlock * SD_BLOCK, SEEK_SET);
+            fwrite(data, 1, SD_BLOCK, image);
+            writes++;
+            phase = SD_COMMAND;
+            // data accepted, then busy programming
+            send(0xe0 | SD_DATA_ACCEPT);
+            for (uint8_t i = 0; i < SD_BUSY_BYTES; i++) {
+                send(0x00);
+            }
+        }
+        return 0xff;
+    }
+    
+    if (framed == 0 && (byte & 0xc0) != 0x40) {
+        return 0xff;
+    }
+    frame[framed++] = byte;
+    if (framed == sizeof (frame)) {
+        framed = 0;
+        command();
+    }
+    
+    return 0xff;
+}
+
+/**
+ * Ends a transaction with the card, which must not be in the middle of
+ * a command, response or data block, except while it is busy programming.
+ */
+static void sdDeselect(void) {
+    bool busy = outLength > 0;
+    for (uint16_t i = outHead; i < outLength; i++) {
+        if (out[i] != 0x00) {
+            busy = false;
+        }
+    }
+    if (framed > 0 || phase != SD_COMMAND || (outLength > 0 && !busy)) {
+        violations++;
+    }
+    framed = 0;
+    phase = SD_COMMAND;
+    outHead = outLength = 0;
+}
+
+/**
+ * Exchanges the given byte with the SRAM.
+ * @param byte
+ * @return byte sent by the SRAM
+ */
+static uint8_t sramTransmit(uint8_t byte) {
+    if (sramCmd == 0) {
+        sramCmd = byte;
+        sramAddrBytes = 0;
+        sramAddr = 0;
+        return 0xff;
+    }
+    
+    if (sramCmd == SRAM_RDSR) {
+        return sramMode;
+    }
+    if (sramCmd == SRAM_WRSR) {
+        sramMode = byte;
+        return 0xff;
+    }
+    
+    if (sramAddrBytes < (SRAM_23LC1024 ? 3 : 2)) {
+        sramAddr = (sramAddr << 8) | byte;
+        sramAddrBytes++;
+        return 0xff;
+    }
+    
+    uint8_t read = 0xff;
+    sramAddr &= SRAM_HIGH;
+    if (sramCmd == SRAM_WRITE) {
+        sram[sramAddr] = byte;
+    } else if (sramCmd == SRAM_READ) {
+        read = sram[sramAddr];
+    }
+    sramAddr++;
+    
+    return read;
+}
+
+void sdemuInsert(FILE *file, bool sdhc) {
+    image = file;
+    blockAddressing = sdhc;
+    idle = false;
+    app = false;
+    phase = SD_COMMAND;
+    framed = 0;
+    outHead = outLength = 0;
+}
+
+long sdemuWrites(void) {
+    return writes;
+}
+
+long sdemuViolations(void) {
+    return violations;
+}
+
+void sramSel(void) {
+    selected = SEL_SRAM;
+    sramCmd = 0;
+}
+
+void sramDes(void) {
+    selected = SEL_NONE;
+}
+
+void sdSel(void) {
+    selected = SEL_SD;
+}
+
+void sdDes(void) {
+    if (selected == SEL_SD) {
+        sdDeselect();
+    }
+    selected = SEL_NONE;
+}
+
+void displaySel(void) {
+    abort();
+}
+
+void displayDes(void) {
+}
+
+void spiBegin(uint8_t device) {
+    if (device == SPI_SRAM) {
+        sramSel();
+    } else if (device == SPI_SD || device == SPI_SD_INIT) {
+        sdSel();
+    } else {
+        displaySel();
+    }
+}
+
+void spiEnd(uint8_t device) {
+    if (device == SPI_SRAM) {
+        sramDes();
+    } else {
+        sdDes();
+        transmit(0xff);
+    }
+}
+
+uint8_t transmit(uint8_t byte) {
+    if (selected == SEL_SRAM) {
+        return sramTransmit(byte);
+    }
+    if (selected == SEL_SD && image != NULL) {
+        return sdTransmit(byte);
+    }
+    
+    return 0xff;
+}
+
+void transmitBytes(const uint8_t *data, uint16_t length) {
+    while (length-- > 0) {
+        transmit(*data++);
+    }
+}
+
+void transmitRepeat(uint8_t data, uint16_t length) {
+    while (length-- > 0) {
+        transmit(data);
+    }
+}
+
+void receiveBytes(uint8_t *data, uint16_t length) {
+    while (length-- > 0) {
+        *data++ = transmit(0);
+    }
+}
@@ -0,0 +1,36 @@
+/* 
+ * File:   sdemu.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:37
+ */
+
+#ifndef SDEMU_H
+#define SDEMU_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * Inserts the card with the given image file, an SDHC card addressed by 
+ * block if sdhc is true, an SDSC card addressed by byte otherwise. The 
+ * card needs to be initialized again after it was inserted.
+ * @param image
+ * @param sdhc
+ */
+void sdemuInsert(FILE *image, bool sdhc);
+
+/**
+ * Returns the number of blocks written to the card.
+ * @return blocks written
+ */
+long sdemuWrites(void);
+
+/**
+ * Returns the number of times the card was deselected in the middle of 
+ * a command, response or data block, which the card does not allow.
+ * @return violations
+ */
+long sdemuViolations(void);
+
+#endif /* SDEMU_H */
@@ -0,0 +1,80 @@
+/* 
+ * File:   sdlog.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:37
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdemu.h"
+#include "logger.h"
+#include "sram.h"
+
+/*
+ * Logs the given number of samples to the given card image like the meter
+ * does, optionally swapping the card for another image halfway through.
+ * 
+ * Usage: sdlog image sdhc samples [swap]
+ */
+
+/**
+ * Opens the given image file for reading and writing.
+ * @param path
+ * @return image
+ */
+static FILE *openImage(const char *path) {
+    FILE *image = fopen(path, "r+b");
+    if (image == NULL) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    
+    return image;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s image sdhc samples [swap]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    bool sdhc = atoi(argv[2]);
+    long samples = atol(argv[3]);
+    FILE *image = openImage(argv[1]);
+    FILE *swap = argc > 4 ? openImage(argv[4]) : NULL;
+    sdemuInsert(image, sdhc);
+    
+    sramAlloc(SRAM_LOG, LOG_SAMPLES * LOG_SAMPLE);
+    
+    int flushes = 0;
+    int fails = 0;
+    for (long i = 0; i < samples; i++) {
+        if (swap != NULL && i == samples / 2) {
+            sdemuInsert(swap, sdhc);
+        }
+        Sample sample = {
+            .tmpx10 = (i * 7) % 700 - 150,
+            .rh = i % 100,
+            .vBatx10 = 30 + i % 15
+        };
+        logAdd(sample);
+        if (logPending()) {
+            flushes++;
+            if (!logFlush()) {
+                fails++;
+            }
+        }
+    }
+    
+    fclose(image);
+    if (swap != NULL) {
+        fclose(swap);
+    }
+    
+    long violations = sdemuViolations();
+    printf("flushes %d fails %d writes %ld violations %ld\n", 
+            flushes, fails, sdemuWrites(), violations);
+    
+    return fails > 0 || violations > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+/* 
+ * File:   delay.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:37
+ */
+
+#ifndef DELAY_H
+#define DELAY_H
+
+/*
+ * Host stand-in for <util/delay.h>, the emulated devices do not need any
+ * time to pass.
+ */
+
+static inline void _delay_ms(double ms) {
+    (void) ms;
+}
+
+static inline void _delay_us(double us) {
+    (void) us;
+}
+
+#endif /* DELAY_H */
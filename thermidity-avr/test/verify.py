@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+#
+# File:   verify.py
+# Author: agent@local
+#
+# Created on 18. October 2026, 17:37
+#
+# Verifies that the log file in the given card images written by sdlog 
+# has no holes and consecutive records with the values of the samples, 
+# ignoring a partial first and last record split with another card.
+#
+# Usage: verify.py image...
+
+import json
+import sys
+
+BLOCK = 512
+
+
+def expected(number):
+    tmpx10 = (number * 7) % 700 - 150
+    tmp = '%s%d.%d' % ('-' if tmpx10 < 0 else '', abs(tmpx10) // 10,
+                       abs(tmpx10) % 10)
+    bat = 30 + number % 15
+    return '%d,%s,%d,%d.%d' % (number, tmp, number % 100, bat // 10, bat % 10)
+
+
+failed = False
+for path in sys.argv[1:]:
+    with open(path, 'rb') as file:
+        image = file.read()
+    with open(path + '.json') as file:
+        blocks = json.load(file)
+
+    data = b''.join(image[b * BLOCK:(b + 1) * BLOCK] for b in blocks)
+    text = data.rstrip(b'\0')
+    lines = text.decode().split('\n')
+    records = lines[1:-1]
+    problems = []
+    if b'\0' in text:
+        problems.append('hole')
+    if not records:
+        problems.append('no records')
+    for prev, line in zip(records, records[1:]):
+        if int(line.split(',')[0]) != int(prev.split(',')[0]) + 1:
+            problems.append('gap after %s' % prev)
+            break
+    for line in records:
+        if line != expected(int(line.split(',')[0])):
+            problems.append('record %s' % line)
+            break
+
+    print('%s: %d blocks, %d records %s' % (path, -(-len(text) // BLOCK),
+          len(records), ', '.join(problems) if problems else 'ok'))
+    failed = failed or bool(problems)
+
+sys.exit(1 if failed else 0)
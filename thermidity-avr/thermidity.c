@@ -31,23 +31,21 @@
 #include "display.h"
 #include "utils.h"
 #include "usart.h"
-
-/* Measure and average temperature and relative humidity every ~32 seconds */
-#define MEASURE_INTS    4 // should be a power of 2 to avoid division 
-/* Display should not be updated more frequently than once every 180 seconds */
-#define DISP_UPD_INTS   36
-/* Number of fast updates until a full update is done to avoid ghosting */
-#define DISP_MAX_FAST   9
+#include "sdcard.h"
+#include "logger.h"
+#include "config.h"
+#include "cmd.h"
+#include "state.h"
+#include "timing.h"
+#include "battery.h"
+#include "power.h"
+#include "sched.h"
 
 /* 1 int = 8 seconds */
-static volatile uint8_t ints = DISP_UPD_INTS;
+#define INT_SECS    SCHED_PERIOD
 
 static uint8_t updates = DISP_MAX_FAST + 1;
 
-ISR(WDT_vect) {
-    ints++;
-}
-
 EMPTY_INTERRUPT(ADC_vect);
 
 /**
@@ -83,6 +81,13 @@ static void initPins(void) {
     // set display BUSY pin as input pin (default)
     DDR_DISP &= ~(1 << PIN_BUSY);
 
+#if SD_LOG
+    // set SD card CS and power pin as output pin, driven low while the 
+    // card is powered off to not power it via CS
+    DDR_SD |= (1 << PIN_SDCS);
+    DDR_SD |= (1 << PIN_SDPWR);
+#endif
+
     // pull all unused pins high/set to defined level to reduce current
     // consumption when not in sleep mode
     PORTB |= (1 << PB6);
@@ -91,29 +96,38 @@ static void initPins(void) {
     PORTC |= (1 << PC5);
     PORTD |= (1 << PD0);
     PORTD |= (1 << PD1);
+#if !SD_LOG
     PORTD |= (1 << PD2);
     PORTD |= (1 << PD3);
+#endif
     PORTD |= (1 << PD4);
 }
 
 /**
- * Enables SPI master mode.
+ * Enables SPI master mode. Clock and mode are applied per device with
+ * each SPI transaction.
  */
 static void initSPI(void) {
-    SPCR |= (1 << SPR0);
     SPCR |= (1 << MSTR);
 }
 
 /**
- * Sets up the watchdog.
+ * Partitions the SRAM into regions: the frame buffer unless rendering in
+ * bands, the previous frame and background if the SRAM is large enough,
+ * the SD card log buffer and the history log in what is left.
  */
-static void initWatchdog(void) {
-    cli();
-    wdt_reset();
-    // watchdog change enable
-    WDTCSR |= (1 << WDCE) | (1 << WDE);
-    // enable interrupt, disable system reset, bark every 8 seconds
-    WDTCSR = (1 << WDIE) | (0 << WDE) | (1 << WDP3) | (1 << WDP0);
+static void initSRAM(void) {
+#if !RENDER_BANDED
+    sramAlloc(SRAM_FRAME, DISPLAY_BYTES);
+#endif
+#if SRAM_SIZE >= 4UL * DISPLAY_BYTES
+    sramAlloc(SRAM_PREV_FRAME, DISPLAY_BYTES);
+    sramAlloc(SRAM_BACKGROUND, DISPLAY_BYTES);
+#endif
+#if SD_LOG
+    sramAlloc(SRAM_LOG, LOG_SAMPLES * LOG_SAMPLE);
+#endif
+    sramAlloc(SRAM_HISTORY, 0);
 }
 
 /**
@@ -129,116 +143,254 @@ static void initADC(void) {
 }
 
 /**
- * Powers on the sensors.
+ * Powers on the SD card and gives it time to ramp up.
  */
-static void powerOnSensors(void) {
-    PORT_SENS |= (1 << PIN_PWR);
+static void powerOnSD(void) {
+    powerOn(POWER_SD);
+    _delay_ms(10);
 }
 
 /**
- * Powers off the sensors.
- */
-static void powerOffSensors(void) {
-    PORT_SENS &= ~(1 << PIN_PWR);
-}
-
-/**
- * Enables the ADC.
+ * Starts the clock of the ADC and enables it.
  */
 static void enableADC(void) {
+    powerOn(POWER_ADC);
     ADCSRA |= (1 << ADEN);
 }
 
 /**
- * Disables the ADC.
+ * Disables the ADC and stops its clock.
  */
 static void disableADC(void) {
     ADCSRA &= ~(1 << ADEN);
+    powerOff(POWER_ADC);
+}
+
+#if BAT_LOAD
+/**
+ * Measures the battery voltage under the load of the display updating.
+ */
+static void measureLoad(void) {
+    // give the reference and the load some time to settle
+    enableADC();
+    _delay_ms(BAT_LOAD_DELAY);
+    measureBatLoad();
+    disableADC();
 }
+#endif
 
 /**
- * Enables SPI.
+ * Starts the clock of SPI and enables it.
  */
 static void enableSPI(void) {
+    powerOn(POWER_SPI);
     SPCR |= (1 << SPE);
+#if DISPLAY_MSPIM
+    enableMSPIM();
+#endif
 }
 
 /**
- * Disables SPI.
+ * Disables SPI and stops its clock.
  */
 static void disableSPI(void) {
     SPCR &= ~(1 << SPE);
     PORT_SPI &= ~(1 << PIN_SCK);
+    powerOff(POWER_SPI);
+#if DISPLAY_MSPIM
+    disableMSPIM();
+#endif
 }
 
 /**
- * Stops the clock of unused modules to reduce power consumption.
+ * Parks the pins in their lowest leakage state: chip selects and display 
+ * control pins high, SPI and sensor and SD card power pins low, and the 
+ * remaining inputs pulled up.
  */
-static void reducePower(void) {
-    // stop TWI, Timer0, Timer1, Timer2 and USART
-    PRR |= (1 << PRTWI) | (1 << PRTIM0) | (1 << PRTIM1) | (1 << PRTIM2) | (1 << PRUSART0);
+static void parkPins(void) {
+    PORT_SENS &= ~(1 << PIN_PWR);
+    PORT_SPI &= ~((1 << PIN_MOSI) | (1 << PIN_SCK));
+    PORT_SSPI |= (1 << PIN_SRCS);
+    PORT_DSPI |= (1 << PIN_ECS) | (1 << PIN_DC);
+    PORT_DISP |= (1 << PIN_RST);
+#if SD_LOG
+    PORT_SD &= ~((1 << PIN_SDPWR) | (1 << PIN_SDCS));
+#endif
+    // release TXD/XCK from the USART and pull them and RXD up
+    PORTD |= (1 << PIN_RXD) | (1 << PIN_TXD) | (1 << PIN_XCK);
 }
 
 /**
- * Disables global interrupts and the watchdog to stop measuring 
- * and updating the display when batteries are too weak, to limit 
- * discharging below cutoff voltage.
+ * Stops measuring and updating the display for good when the batteries 
+ * are too weak, to limit discharging below cutoff voltage: disables all 
+ * interrupts, the watchdog and the clock of all modules regardless of 
+ * their users, parks the pins and sleeps in power-down sleep mode with BOD 
+ * disabled until the batteries are replaced.
  */
 static void powerDown(void) {
     cli();
     wdt_disable();
+    
+    // no pin change wakes up the MCU anymore
+    PCICR = 0;
+    UCSR0B = 0;
+    ADCSRA = 0;
+    SPCR = 0;
+    PRR = (1 << PRTWI) | (1 << PRTIM2) | (1 << PRTIM0) | (1 << PRTIM1) |
+            (1 << PRSPI) | (1 << PRUSART0) | (1 << PRADC);
+    parkPins();
+    
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    while (true) {
+        // BOD disable is only effective for the next sleep
+        sleep_bod_disable();
+        sleep_cpu();
+    }
+}
+
+/**
+ * Returns the time until the USART is ticked again.
+ * @return seconds
+ */
+static uint16_t usartPeriod(void) {
+    return INT_SECS;
 }
 
+/**
+ * Returns the time until the next measurement, which is with each 
+ * watchdog interrupt while warming up.
+ * @return seconds
+ */
+static uint16_t measurePeriod(void) {
+    return isWarmingUp() ? INT_SECS : config.measureInts * INT_SECS;
+}
+
+/**
+ * Returns the time until the next display update.
+ * @return seconds
+ */
+static uint16_t updatePeriod(void) {
+    return config.dispUpdInts * INT_SECS;
+}
+
+/**
+ * Powers on the sensors, measures and powers them off.
+ */
+static void measure(void) {
+    powerOn(POWER_SENSORS);
+    // give the humidity sensor time to settle
+    PHASE_BEGIN();
+    _delay_ms(100);
+    PHASE_END(PHASE_SETTLE);
+    enableADC();
+    PHASE_BEGIN();
+    measureValues();
+    PHASE_END(PHASE_ADC);
+    disableADC();
+    powerOff(POWER_SENSORS);
+}
+
+/**
+ * Records and displays the measured values and flushes the log, or shows
+ * a note and powers down when the batteries are too weak.
+ */
+static void update(void) {
+    // measured battery voltage is /5 by voltage divider,
+    // weak batteries sag under the load of an update
+    if (getMVBatLoad() < derived.batLow5) {
+        saveState(updates);
+        // leave a note instead of stale values
+        enableSPI();
+        displayBatteryLow();
+        disableSPI();
+        powerDown();
+    }
+    
+    enableSPI();
+    recordValues();
+#if SD_LOG
+    if (logPending()) {
+        // write the buffered log in one burst every few 
+        // hours as the SD card draws tens of mA
+        powerOnSD();
+        logFlush();
+        powerOff(POWER_SD);
+        accountCharge(CHARGE_SD);
+    }
+#endif
+    if (updates > config.dispMaxFast) {
+        // make a full update after a certain number of 
+        // fast updates to avoid ghosting
+        displayValues(false);
+        updates = 0;
+    } else {
+        if (displayValues(true)) {
+            updates++;
+        }
+    }
+    disableSPI();
+    checkpointState(updates);
+}
+
+/* 
+ * The tasks, all due initially, measuring before updating the display 
+ * when both are due
+ */
+static Task tasks[] = {
+    {0, usartPeriod, tickUSART, 0},
+    {1, measurePeriod, measure, 0},
+    {2, updatePeriod, update, 0}
+};
+
 int main(void) {
 
-    reducePower();
+    loadConfig();
     initPins();
     initSPI();
-    initWatchdog();
+    initSRAM();
+    initScheduler();
     initADC();
-    // initUSART();
+    initPower();
+#if BAT_LOAD
+    setUpdateHook(measureLoad);
+#endif
+#if !DISPLAY_MSPIM
+    initUSART();
+#endif
 
     // enable global interrupts
     sei();
     
-    // delay initial display update after power on
-    _delay_ms(1000);
+    // resume with the state before a reset, i.e. a brown-out, without 
+    // full update, otherwise delay initial display update after power on
+    if (!restoreState(&updates)) {
+        _delay_ms(1000);
+    }
 
     while (true) {
-        if (ints % MEASURE_INTS == 0) {
-            powerOnSensors();
-            // give the humidity sensor time to settle
-            _delay_ms(100);
-            enableADC();
-            measureValues();
-            disableADC();
-            powerOffSensors();
-
-            if (ints >= DISP_UPD_INTS) {
-                ints = 0;
-
-                // measured battery voltage is /5 by voltage divider
-                if (getMVBat() < BAT_LOW / 5) {
-                    powerDown();
-                } else {
-                    enableSPI();
-                    if (updates > DISP_MAX_FAST) {
-                        // make a full update after a certain number of fast 
-                        // updates to avoid ghosting
-                        displayValues(false);
-                        updates = 0;
-                    } else {
-                        if (displayValues(true)) {
-                            updates++;
-                        }
-                    }
-                    disableSPI();
-                }
-            }
+        if (isUSARTReceived()) {
+            char line[USART_LENGTH];
+            getUSARTData(line, sizeof (line));
+            runCommand(line);
+        }
+        
+        if (schedPending()) {
+            uint16_t elapsed = schedElapsed();
+            accountSleep(elapsed);
+            elapseMinMax(elapsed);
+            TIMING_START(elapsed);
+            runTasks(tasks, ARRAY_LENGTH(tasks));
+            TIMING_STOP();
         }
 
-        set_sleep_mode(SLEEP_MODE_PWR_DOWN);
-        sleep_mode();
+        // sleep until the watchdog barks or a line was received, in the 
+        // deepest sleep mode the modules in use allow
+        cli();
+        if (!schedPending() && !isUSARTReceived()) {
+            powerSleep();
+        }
+        sei();
     }
 
     return 0;
@@ -0,0 +1,79 @@
+/* 
+ * File:   timing.c
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:07
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "timing.h"
+#include "power.h"
+
+#if TIMING
+
+static Timing timing;
+
+/* Overflows of Timer1 since it was started */
+static volatile uint16_t overflows = 0;
+
+/* Time when the current phase began */
+static uint32_t begin = 0;
+
+ISR(TIMER1_OVF_vect) {
+    overflows++;
+}
+
+/**
+ * Returns the time in Timer1 ticks since it was started.
+ * @return ticks
+ */
+static uint32_t now(void) {
+    uint16_t high;
+    uint16_t low;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        low = TCNT1;
+        high = overflows;
+        // overflow not handled yet
+        if (bit_is_set(TIFR1, TOV1) && low < 0x8000) {
+            high++;
+        }
+    }
+    
+    return ((uint32_t)high << 16) | low;
+}
+
+void timingStart(uint16_t secs) {
+    powerOn(POWER_TIMER1);
+    TCNT1 = 0;
+    overflows = 0;
+    TIFR1 = (1 << TOV1);
+    TIMSK1 = (1 << TOIE1);
+    // prescaler 1024, 128 µs per tick @ 8 MHz
+    TCCR1B = (1 << CS12) | (1 << CS10);
+    timing.wakeups++;
+    timing.seconds += secs;
+}
+
+void timingStop(void) {
+    timing.awake += now();
+    TCCR1B = 0;
+    TIMSK1 = 0;
+    powerOff(POWER_TIMER1);
+}
+
+void phaseBegin(void) {
+    begin = now();
+}
+
+void phaseEnd(uint8_t phase) {
+    timing.ticks[phase] += now() - begin;
+    timing.counts[phase]++;
+}
+
+const Timing * getTiming(void) {
+    return &timing;
+}
+
+#endif
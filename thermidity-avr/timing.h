@@ -0,0 +1,91 @@
+/* 
+ * File:   timing.h
+ * Author: agent@local
+ *
+ * Created on 18. October 2026, 17:07
+ */
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** 
+ * Measure the awake time per phase with Timer1, for debugging only, which
+ * polls the AD conversions instead of sleeping as Timer1 is halted in ADC 
+ * noise reduction mode
+ */
+#ifndef TIMING
+#define TIMING  0
+#endif
+
+/** Phases whose time is accumulated */
+#define PHASE_SETTLE    0 // sensors settling
+#define PHASE_ADC       1 // AD conversions
+#define PHASE_RENDER    2 // drawing the frame
+#define PHASE_TRANSFER  3 // transferring the frame to the display
+#define PHASE_BUSY      4 // waiting for the display not being busy
+#define PHASES          5
+
+/** Timer1 ticks per millisecond with prescaler 1024 at F_CPU */
+#define TIMING_TICKS_MS (F_CPU / 1024 / 1000.0)
+
+#if TIMING
+#define TIMING_START(secs)  timingStart(secs)
+#define TIMING_STOP()       timingStop()
+#define PHASE_BEGIN()       phaseBegin()
+#define PHASE_END(phase)    phaseEnd(phase)
+#else
+#define TIMING_START(secs)
+#define TIMING_STOP()
+#define PHASE_BEGIN()
+#define PHASE_END(phase)
+#endif
+
+/**
+ * Accumulated time and number of each phase and of being awake.
+ */
+typedef struct {
+    /** Timer1 ticks spent in each phase. */
+    uint32_t ticks[PHASES];
+    /** Number of times each phase was entered. */
+    uint16_t counts[PHASES];
+    /** Timer1 ticks spent awake between start and stop. */
+    uint32_t awake;
+    /** Number of times the MCU was woken up by the watchdog. */
+    uint16_t wakeups;
+    /** Seconds elapsed, asleep and awake. */
+    uint32_t seconds;
+} Timing;
+
+/**
+ * Starts the clock of Timer1 and starts timing a period of being awake,
+ * adding the given seconds elapsed since the last period.
+ * @param secs
+ */
+void timingStart(uint16_t secs);
+
+/**
+ * Stops timing a period of being awake and stops the clock of Timer1.
+ */
+void timingStop(void);
+
+/**
+ * Begins a phase. Phases must not be nested.
+ */
+void phaseBegin(void);
+
+/**
+ * Ends the given phase and adds its time.
+ * @param phase
+ */
+void phaseEnd(uint8_t phase);
+
+/**
+ * Returns the accumulated timing.
+ * @return timing
+ */
+const Timing * getTiming(void);
+
+#endif /* TIMING_H */
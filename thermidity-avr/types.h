@@ -14,13 +14,13 @@ typedef uint8_t height_t;
 
 /* Number of rows and columns of the display */
 typedef uint8_t row_t;
-typedef uint8_t col_t;
+typedef uint16_t col_t;
 
-/* Char code (like UTF-8 code point) */
-typedef uint8_t code_t;
+/* Char code (Unicode code point of the Basic Multilingual Plane) */
+typedef uint16_t code_t;
 
 /* Number of glyphs of a font */
-typedef uint8_t length_t;
+typedef uint16_t length_t;
 
 #endif /* TYPES_H */
 
@@ -770,6 +770,22 @@ static const __flash uint8_t y_diaeresis[] = {
     0x00, 0x00, 0x24, 0x24, 0x00, 0x00, 0x42, 0x42, 
     0x42, 0x42, 0x42, 0x26, 0x1A, 0x02, 0x02, 0x3C};
 
+static const __flash uint8_t LEFTWARDS_ARROW[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x20, 
+    0x7E, 0x20, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+static const __flash uint8_t UPWARDS_ARROW[] = {
+    0x00, 0x00, 0x00, 0x00, 0x08, 0x1C, 0x2A, 0x49, 
+    0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00};
+
+static const __flash uint8_t RIGHTWARDS_ARROW[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x04, 
+    0x7E, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+static const __flash uint8_t DOWNWARDS_ARROW[] = {
+    0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x08, 0x08, 
+    0x08, 0x08, 0x49, 0x2A, 0x1C, 0x08, 0x00, 0x00};
+
 static const __flash uint8_t SMILING_FACE[] = {
     0x00, 0x00, 0x00, 0x00, 0x3C, 0x42, 0x81, 0xA5, 
     0x81, 0xA5, 0x99, 0x42, 0x3C, 0x00, 0x00, 0x00};
@@ -967,7 +983,20 @@ static const __flash Glyph glyphs[] = {
     {0x00fc, WIDTH, u_diaeresis},
     {0x00fd, WIDTH, y_acute},
     {0x00fe, WIDTH, thorn},
-    {0x00ff, WIDTH, y_diaeresis}
+    {0x00ff, WIDTH, y_diaeresis},
+    {0x2190, WIDTH, LEFTWARDS_ARROW},
+    {0x2191, WIDTH, UPWARDS_ARROW},
+    {0x2192, WIDTH, RIGHTWARDS_ARROW},
+    {0x2193, WIDTH, DOWNWARDS_ARROW}
+};
+
+static const __flash Range ranges[] = {
+    {0x0007, 0x0007, 0},
+    {0x0020, 0x007e, 1},
+    {0x00a1, 0x00ac, 96},
+    {0x00ae, 0x00ff, 108},
+    {0x2190, 0x2193, 190}
 };
 
-const __flash Font unifontFont = {glyphs, ARRAY_LENGTH(glyphs), HEIGHT};
+const __flash Font unifontFont = {glyphs, ARRAY_LENGTH(glyphs), HEIGHT,
+    ranges, ARRAY_LENGTH(ranges)};
@@ -9,39 +9,197 @@
 #include <string.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
 #include <util/setbaud.h>
 #include "usart.h"
+#include "pins.h"
 #include "utils.h"
+#include "power.h"
 
 static volatile bool usartReceived = false;
 
 static char usartData[USART_LENGTH];
 
+/* Length of the line being received */
+static volatile uint8_t rxLength = 0;
+
+/* If the receiver is enabled, so the clock of the USART must keep running */
+static volatile bool receiving = false;
+
+/* If the clock of the USART is running and it is set up */
+static volatile bool enabled = false;
+
+/* If received bytes are discarded until the first line ending */
+static volatile bool rxSync = false;
+
+/* Watchdog interrupts left without receiving until the receiver is disabled */
+static volatile uint8_t rxTicks = 0;
+
+/* Transmit ring buffer, written at head and drained at tail */
+static volatile char txData[USART_TX_SIZE];
+static volatile uint8_t txHead = 0;
+static volatile uint8_t txTail = 0;
+
 /**
  * Called when data was received via USART.
  */
 ISR(USART_RX_vect) {
-    if (bit_is_set(UCSR0A, RXC0) && !usartReceived) {
-        char data = UDR0;
-        size_t length = strlen(usartData);
-        if (length < USART_LENGTH - 1 && data != '\n' && data != '\r') {
-            usartData[length] = data;
-        } else {
-            usartData[length] = '\0';
+    // the frame error flag must be read before the data register
+    bool frameError = UCSR0A & (1 << FE0);
+    char data = UDR0;
+    rxTicks = USART_RX_TICKS;
+    if (usartReceived || frameError) {
+        return;
+    }
+    
+    if (rxSync) {
+        // the receiver was enabled in the middle of the wake-up frame, so
+        // the bytes until the first line ending may be garbage
+        rxSync = data != '\n' && data != '\r';
+        return;
+    }
+    
+    if (data == '\n' || data == '\r') {
+        // ignore empty lines, i.e. LF after CR or the wake-up line ending
+        if (rxLength > 0) {
+            usartData[rxLength] = '\0';
             usartReceived = true;
         }
+    } else if (rxLength < USART_LENGTH - 1) {
+        usartData[rxLength++] = data;
+    } else {
+        usartData[rxLength] = '\0';
+        usartReceived = true;
     }
 }
 
-void initUSART(void) {
+/**
+ * Called when the data register is empty, transmits the next byte from 
+ * the buffer or waits for the last byte to be shifted out.
+ */
+ISR(USART_UDRE_vect) {
+    if (txHead == txTail) {
+        UCSR0B &= ~(1 << UDRIE0);
+        UCSR0B |= (1 << TXCIE0);
+        return;
+    }
+    
+    UDR0 = txData[txTail];
+    // clear a transmit complete flag left from before, now that the buffer
+    // is not empty, writing the error flags zero as required and keeping 
+    // the double speed bit
+    UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << TXC0);
+    txTail = (txTail + 1) & (USART_TX_SIZE - 1);
+}
+
+/**
+ * Disables the USART and stops its clock.
+ */
+static void disableUSART(void) {
+    UCSR0B = 0;
+    enabled = false;
+    powerOff(POWER_USART);
+}
+
+/**
+ * Called when the last byte was shifted out, stops the clock of the 
+ * USART unless receiving.
+ */
+ISR(USART_TX_vect) {
+    UCSR0B &= ~(1 << TXCIE0);
+    if (txHead == txTail && !receiving) {
+        disableUSART();
+    }
+}
+
+/**
+ * Starts the clock of the USART if it was stopped and sets it up, as it 
+ * needs to be reinitialized after its clock was stopped.
+ */
+static void enableUSART(void) {
+    if (enabled) {
+        return;
+    }
+    
+    powerOn(POWER_USART);
+    enabled = true;
     UBRR0H = UBRRH_VALUE;
     UBRR0L = UBRRL_VALUE;
-
-    UCSR0B = (1 << TXEN0) | (1 << RXEN0);
+#if USE_2X
+    UCSR0A = (1 << U2X0);
+#else
+    UCSR0A = 0;
+#endif
     UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    UCSR0B = (1 << TXEN0);
+}
+
+/**
+ * Called when a pin change on RXD is detected, enables the receiver 
+ * on a start bit.
+ */
+ISR(PCINT2_vect) {
+    if (bit_is_clear(PINP_USART, PIN_RXD)) {
+        PCMSK2 &= ~(1 << PCINT16);
+        receiving = true;
+        rxSync = true;
+        rxTicks = USART_RX_TICKS;
+        enableUSART();
+        UCSR0B |= (1 << RXEN0);
+        // enable USART RX complete interrupt 0
+        UCSR0B |= (1 << RXCIE0);
+    }
+}
+
+void initUSART(void) {
+    PCMSK2 |= (1 << PCINT16);
+    PCICR |= (1 << PCIE2);
+}
+
+void tickUSART(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (!receiving || usartReceived || --rxTicks > 0) {
+            return;
+        }
+        
+        // discard an incomplete line
+        rxLength = 0;
+        receiving = false;
+        UCSR0B &= ~((1 << RXEN0) | (1 << RXCIE0));
+        if (!(UCSR0B & ((1 << UDRIE0) | (1 << TXCIE0)))) {
+            // not transmitting, stop the clock
+            disableUSART();
+        }
+        PCMSK2 |= (1 << PCINT16);
+    }
+}
+
+/**
+ * Queues the given byte, waiting in idle sleep mode while the buffer is full.
+ * @param c
+ */
+static void printChar(char c) {
+    uint8_t next = (txHead + 1) & (USART_TX_SIZE - 1);
+    
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (true) {
+        cli();
+        if (next != txTail) {
+            break;
+        }
+        // the data register empty interrupt wakes up from idle sleep
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
     
-    // enable USART RX complete interrupt 0
-    UCSR0B |= (1 << RXCIE0);
+    txData[txHead] = c;
+    txHead = next;
+    enableUSART();
+    UCSR0B = (UCSR0B & ~(1 << TXCIE0)) | (1 << UDRIE0);
+    sei();
 }
 
 bool isUSARTReceived(void) {
@@ -52,17 +210,15 @@ void getUSARTData(char *data, size_t size) {
     if (size > 0) {
         data[0] = '\0';
         strncat(data, usartData, size - 1);
-        memset(usartData, 0, USART_LENGTH);
+        rxLength = 0;
         usartReceived = false;
     }
 }
 
 void printString(const char *data) {
-    uint8_t i = 0;
     char c;
-    while ((c = data[i++]) != '\0') {
-        loop_until_bit_is_set(UCSR0A, UDRE0);
-        UDR0 = c;
+    while ((c = *data++) != '\0') {
+        printChar(c);
     }
 }
 
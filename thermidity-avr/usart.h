@@ -13,15 +13,31 @@
 
 #define USART_LENGTH 73
 
+/** Size of the transmit ring buffer, must be a power of 2 */
+#define USART_TX_SIZE 64
+
+/** Watchdog interrupts without receiving until the receiver is disabled */
+#define USART_RX_TICKS 4
+
 #ifndef BAUD
 #define BAUD 9600
 #endif
 
 /**
- * Sets the baudrate and enables the transmitter and receiver.
+ * Arms the receiver to be enabled when a start bit on RXD wakes up the MCU
+ * via pin change interrupt, as the USART cannot wake up from power-down 
+ * sleep mode. The receiver is enabled in the middle of the frame whose start
+ * bit was detected, so bytes are discarded until the first line ending and 
+ * a line ending should be sent first to wake up.
  */
 void initUSART(void);
 
+/**
+ * Disables the receiver and arms it again if nothing was received during
+ * USART_RX_TICKS calls, to be called every 8 seconds.
+ */
+void tickUSART(void);
+
 /**
  * Returns true if a CR or LF terminated line of data was received via USART.
  */
@@ -34,7 +50,9 @@ bool isUSARTReceived(void);
 void getUSARTData(char *data, size_t length);
 
 /**
- * Prints the given string via USART.
+ * Queues the given string to be printed via USART by the data register 
+ * empty interrupt, starting the clock of the USART if it was stopped. 
+ * Only waits in idle sleep mode while the transmit buffer is full.
  */
 void printString(const char *data);
 